@@ -0,0 +1,189 @@
+//
+//  Bench.cpp
+//  CloudSim
+//
+//  Simulator throughput benchmark. For each size it generates a synthetic cluster and workload in the
+//  Input.md format, runs the simulator on it with the profiler enabled (see Profile.hpp), and prints one
+//  JSON object per run so the numbers can be compared across builds. Throughput is callbacks_per_sec, the
+//  scheduler callbacks per wall clock second, since the simulator's own event count is not visible.
+//
+//  Usage: bench [-s simulator] [-d work_dir] [-r seed] [machines:tasks ...]
+//  The default sizes are 40:10000 and 400:100000. The inputs and profiles go to a fresh directory under
+//  work_dir (/tmp by default), which is removed when the runs are done.
+//
+//  The cluster is 40% X86 machines with GPUs and 60% ARM machines. The workload mixes WEB requests,
+//  STREAM and AI tasks for X86 in a 6:3:1 ratio, with the arrival window sized to keep the X86 cores
+//  about half busy. The scheduler runs its round robin over all X86 machines and powers off the ARM ones.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "Runner.hpp"
+
+typedef struct {
+    const char * type;
+    double share;                           // Fraction of the tasks
+    uint64_t runtime;                       // Expected runtime in us
+    unsigned memory;
+    const char * sla;
+    const char * gpu;
+} BenchClass_t;
+
+static const BenchClass_t bench_classes[] = {
+    { "WEB",    0.6,    100000,     8,      "SLA0", "no"  },
+    { "STREAM", 0.3,    5000000,    64,     "SLA1", "no"  },
+    { "AI",     0.1,    2000000,    512,    "SLA2", "yes" },
+};
+
+#define X86_CORES   8
+#define ARM_CORES   16
+#define START_TIME  1000
+
+static unsigned X86Machines(unsigned machines) {
+    return max(1u, machines * 2 / 5);
+}
+
+static void WriteMachineClass(ofstream & file, unsigned count, const char * cpu, unsigned cores, bool gpu) {
+    file << "machine class:\n{\n";
+    file << "        Number of machines: " << count << "\n";
+    file << "        CPU type: " << cpu << "\n";
+    file << "        Number of cores: " << cores << "\n";
+    file << "        Memory: 16384\n";
+    file << "        S-States: [120, 100, 100, 80, 40, 10, 0]\n";
+    file << "        P-States: [12, 8, 6, 4]\n";
+    file << "        C-States: [12, 3, 1, 0]\n";
+    file << "        MIPS: [1000, 800, 600, 400]\n";
+    file << "        GPUs: " << (gpu ? "yes" : "no") << "\n";
+    file << "}\n";
+}
+
+static bool WriteInput(const string & filename, unsigned machines, uint64_t tasks, unsigned seed) {
+    ofstream file(filename);
+    if(!file)
+        return false;
+    unsigned x86 = X86Machines(machines);
+    WriteMachineClass(file, x86, "X86", X86_CORES, true);
+    if(machines > x86)
+        WriteMachineClass(file, machines - x86, "ARM", ARM_CORES, false);
+
+    // Arrival window that keeps half of the X86 cores busy on average
+    double work = 0;
+    for(const BenchClass_t & task_class : bench_classes)
+        work += task_class.share * double(task_class.runtime);
+    uint64_t window = max<uint64_t>(1000, uint64_t(double(tasks) * work / (0.5 * x86 * X86_CORES)));
+
+    for(const BenchClass_t & task_class : bench_classes) {
+        uint64_t count = max<uint64_t>(1, uint64_t(double(tasks) * task_class.share));
+        file << "task class:\n{\n";
+        file << "        Start time: " << START_TIME << "\n";
+        file << "        End time : " << START_TIME + window << "\n";
+        file << "        Inter arrival: " << max<uint64_t>(1, window / count) << "\n";
+        file << "        Expected runtime: " << task_class.runtime << "\n";
+        file << "        Memory: " << task_class.memory << "\n";
+        file << "        VM type: LINUX\n";
+        file << "        GPU enabled: " << task_class.gpu << "\n";
+        file << "        SLA type: " << task_class.sla << "\n";
+        file << "        CPU type: X86\n";
+        file << "        Task type: " << task_class.type << "\n";
+        file << "        Seed: " << seed++ << "\n";
+        file << "}\n";
+    }
+    return true;
+}
+
+static string JsonString(const string & text) {
+    string quoted = "\"";
+    for(char c : text) {
+        if(c == '"' || c == '\\')
+            quoted += '\\';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+// Numbers go out as they are, NaN and infinities as null since JSON has no such numbers, anything else as a string
+static string JsonValue(const string & text) {
+    char * end;
+    double value = strtod(text.c_str(), &end);
+    if(!text.empty() && *end == '\0')
+        return isfinite(value) ? text : "null";
+    return JsonString(text);
+}
+
+int main(int argc, char * argv[]) {
+    string simulator = "./simulator";
+    string directory = "/tmp";
+    unsigned seed = 520230;
+    vector<string> sizes;
+    for(int arg = 1; arg < argc; arg++) {
+        string option = argv[arg];
+        if(option == "-s" && arg + 1 < argc)
+            simulator = argv[++arg];
+        else if(option == "-d" && arg + 1 < argc)
+            directory = argv[++arg];
+        else if(option == "-r" && arg + 1 < argc)
+            seed = unsigned(stoul(argv[++arg]));
+        else if(option.find(':') != string::npos)
+            sizes.push_back(option);
+        else {
+            cerr << "Usage: " << argv[0] << " [-s simulator] [-d work_dir] [-r seed] [machines:tasks ...]" << endl;
+            return 1;
+        }
+    }
+    if(sizes.empty())
+        sizes = { "40:10000", "400:100000" };
+
+    string work = directory + "/bench_XXXXXX";
+    if(mkdtemp(&work[0]) == nullptr) {
+        cerr << "bench: Could not create a directory in " << directory << endl;
+        return 1;
+    }
+    int failures = 0;
+    for(const string & size : sizes) {
+        unsigned machines = unsigned(stoul(size.substr(0, size.find(':'))));
+        uint64_t tasks = stoull(size.substr(size.find(':') + 1));
+        string base = work + "/" + to_string(machines) + "_" + to_string(tasks);
+        if(machines == 0 || tasks == 0 || !WriteInput(base + ".md", machines, tasks, seed)) {
+            cerr << "bench: Could not set up " << size << endl;
+            unlink((base + ".md").c_str());
+            failures++;
+            continue;
+        }
+        string x86 = to_string(X86Machines(machines));
+        vector<string> environment = {
+            "CLOUDSIM_PROFILE=" + base + ".profile",
+            "CLOUDSIM_ACTIVE_MACHINES=" + x86,
+            "CLOUDSIM_POWERED_MACHINES=" + x86,
+            "CLOUDSIM_MIGRATE_AFTER=0"
+        };
+        string output;
+        double wall = 0;
+        string error = Runner_Simulate(simulator, base + ".md", environment, output, wall);
+        map<string, string> profile;
+        if(error.empty() && !Runner_ReadValues(base + ".profile", profile))
+            error = "no profile written";
+        unlink((base + ".md").c_str());
+        unlink((base + ".profile").c_str());
+
+        cout << "{\"machines\": " << machines << ", \"tasks\": " << tasks << ", \"wall_s\": " << wall;
+        if(!error.empty()) {
+            cout << ", \"error\": " << JsonString(error) << "}" << endl;
+            failures++;
+            continue;
+        }
+        for(auto & value : profile)
+            cout << ", " << JsonString(value.first) << ": " << JsonValue(value.second);
+        cout << "}" << endl;
+    }
+    rmdir(work.c_str());
+    return failures ? 1 : 0;
+}
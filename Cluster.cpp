@@ -0,0 +1,444 @@
+//
+//  Cluster.cpp
+//  CloudSim
+//
+
+#include <algorithm>
+
+#include "Cluster.hpp"
+#include "Profile.hpp"
+
+#define NOT_INDEXED unsigned(-1)
+
+// Timer ticks a machine takes to go from one S-state (row) to another (column), as in Machine::SetState()
+static const unsigned transition_ticks[S_STATES][S_STATES] = {
+    {    0,    1,    1,   10,   25,   50,  250 },
+    {    1,    0,    5,   20,   20,   50,  150 },
+    {    5,    1,    0,   10,   20,   50,  150 },
+    {   50,   75,   20,    0,   20,   50,  150 },
+    {  100,   80,   50,   20,    0,   50,  150 },
+    {  200,  150,  100,  100,   50,    0,  150 },
+    { 5000, 4000, 3000, 3000, 3000, 3000,    0 },
+};
+
+// As in Machine::UpdateMemory()
+static unsigned SlowdownFor(uint64_t memory_used, unsigned memory_size) {
+    if(memory_used > 2 * uint64_t(memory_size))
+        return 400;
+    return memory_used > memory_size ? 200 : 100;
+}
+
+// As in VM::VM(): AIX only runs on POWER, and Windows on neither POWER nor RISCV
+bool Cluster::Compatible(VMType_t vm_type, CPUType_t cpu) {
+    if(vm_type == AIX)
+        return cpu == POWER;
+    return vm_type != WIN || (cpu != POWER && cpu != RISCV);
+}
+
+void Cluster::Init() {
+    unsigned total = Machine_GetTotal();
+    machines.reserve(total);
+    for(unsigned i = 0; i < total; i++) {
+        machines.push_back(Machine_GetInfo(MachineId_t(i)));
+        requested_state.push_back(machines.back().s_state);
+    }
+    ready_at.assign(total, 0);
+    incoming.assign(total, 0);
+    machine_vms.resize(total);
+    array<VMId_t, VM_TYPES> none;
+    none.fill(NO_VM);
+    typed_vms.assign(total, none);
+    backlog.assign(total, 0);
+    backlog_at.assign(total, 0);
+    gpu_tasks.assign(total, 0);
+    watermark.resize(total);
+    for(unsigned i = 0; i < total; i++)
+        watermark[i] = machines[i].memory_size;
+
+    index.resize(CPU_TYPES * 2 * S_STATES);
+    index_key.resize(total);
+    index_bucket.assign(total, NOT_INDEXED);
+    for(unsigned i = 0; i < total; i++)
+        Reindex(MachineId_t(i));
+}
+
+unsigned Cluster::Bucket(CPUType_t cpu, bool gpu, MachineState_t s_state) {
+    return (unsigned(cpu) * 2 + (gpu ? 1 : 0)) * S_STATES + unsigned(s_state);
+}
+
+MachineId_t Cluster::FindMachine(CPUType_t cpu, unsigned memory, bool gpu, MachineState_t s_state, const vector<unsigned> * promised) const {
+    for(bool with_gpu : { gpu, true }) {
+        const set<IndexKey_t> & bucket = index[Bucket(cpu, with_gpu, s_state)];
+        for(auto it = bucket.lower_bound(IndexKey_t(memory, 0, 0)); it != bucket.end(); it++)
+            if(promised == nullptr || get<0>(*it) >= memory + (*promised)[get<2>(*it)])
+                return get<2>(*it);
+        if(with_gpu)
+            break;
+    }
+    return NO_MACHINE;
+}
+
+MachineId_t Cluster::MostFree(CPUType_t cpu, bool gpu, MachineState_t s_state) const {
+    for(bool with_gpu : { gpu, true }) {
+        const set<IndexKey_t> & bucket = index[Bucket(cpu, with_gpu, s_state)];
+        if(!bucket.empty()) {
+            // Most headroom, and the least loaded among those
+            auto it = bucket.lower_bound(IndexKey_t(get<0>(*bucket.rbegin()), 0, 0));
+            return get<2>(*it);
+        }
+        if(with_gpu)
+            break;
+    }
+    return NO_MACHINE;
+}
+
+uint64_t Cluster::Backlog(MachineId_t machine_id, Time_t now) const {
+    uint64_t drained = (now - backlog_at[machine_id]) * Rate(machine_id);
+    return backlog[machine_id] > drained ? backlog[machine_id] - drained : 0;
+}
+
+// With a free core the task runs at full speed, otherwise it shares the cores with the backlog
+Time_t Cluster::EstimateCompletion(MachineId_t machine_id, uint64_t instructions, Time_t now) const {
+    return Estimate(machine_id, instructions, Shared(machine_id, instructions) + instructions, machines[machine_id].active_tasks + 1, now);
+}
+
+Time_t Cluster::EstimateRunning(MachineId_t machine_id, TaskId_t task_id, Time_t now) const {
+    uint64_t instructions = Work(machine_id, task_id);
+    return Estimate(machine_id, instructions, Shared(machine_id, instructions), machines[machine_id].active_tasks, now);
+}
+
+Time_t Cluster::ProjectedFinish(MachineId_t machine_id, Time_t now) const {
+    const MachineInfo_t & info = machines[machine_id];
+    if(info.s_state != S0 || info.active_tasks == 0)
+        return now;
+    uint64_t mips = Mips(machine_id);
+    uint64_t capacity = mips * info.num_cpus;
+    return now + max((Backlog(machine_id, now) + capacity - 1) / capacity, (Longest(machine_id) + mips - 1) / mips);
+}
+
+unsigned Cluster::Headroom(MachineId_t machine_id) const {
+    unsigned used = machines[machine_id].memory_used;
+    return used < watermark[machine_id] ? watermark[machine_id] - used : 0;
+}
+
+unsigned Cluster::Slowdown(MachineId_t machine_id, unsigned extra_memory) const {
+    const MachineInfo_t & info = machines[machine_id];
+    return SlowdownFor(uint64_t(info.memory_used) + extra_memory, info.memory_size);
+}
+
+void Cluster::SetWatermark(double fraction, function<void(MachineId_t, bool)> callback) {
+    for(unsigned i = 0; i < machines.size(); i++)
+        watermark[i] = unsigned(double(machines[i].memory_size) * fraction);
+    pressure = callback;
+    for(unsigned i = 0; i < machines.size(); i++)
+        Reindex(MachineId_t(i));
+}
+
+unsigned Cluster::MemoryFree(MachineId_t machine_id) const {
+    const MachineInfo_t & info = machines[machine_id];
+    return info.memory_used < info.memory_size ? info.memory_size - info.memory_used : 0;
+}
+
+Time_t Cluster::TimeToReady(MachineId_t machine_id, Time_t now) const {
+    if(!InTransition(machine_id))
+        return 0;
+    return ready_at[machine_id] > now ? ready_at[machine_id] - now : 0;
+}
+
+Time_t Cluster::TransitionLatency(MachineState_t from, MachineState_t to) {
+    return Time_t(transition_ticks[from][to]) * TIMER_PERIOD;
+}
+
+unsigned Cluster::VMMemory(VMId_t vm_id) const {
+    unsigned memory = VM_MEMORY_OVERHEAD;
+    for(TaskId_t task_id : vms[vm_id].active_tasks)
+        memory += GetTaskMemory(task_id);
+    return memory;
+}
+
+VMId_t Cluster::TaskVM(TaskId_t task_id) const {
+    auto it = task_vm.find(task_id);
+    return it != task_vm.end() ? it->second : NO_VM;
+}
+
+void Cluster::AddTask(VMId_t vm_id, TaskId_t task_id, Priority_t priority) {
+    {
+        ProfileScope profile(PROFILE_VM_ADD_TASK);
+        VM_AddTask(vm_id, task_id, priority);
+    }
+    VMInfo_t & vm = vms[vm_id];
+    vm.active_tasks.push_back(task_id);
+    task_vm[task_id] = vm_id;
+    Settle(vm.machine_id);
+    backlog[vm.machine_id] += Work(vm.machine_id, task_id);
+    gpu_tasks[vm.machine_id] += Accelerated(vm.machine_id, task_id) ? 1 : 0;
+    machines[vm.machine_id].active_tasks++;
+    UpdateMemory(vm.machine_id, int(GetTaskMemory(task_id)));
+    Reindex(vm.machine_id);
+}
+
+void Cluster::AddTasks(VMId_t vm_id, const vector<pair<TaskId_t, Priority_t>> & tasks) {
+    VMInfo_t & vm = vms[vm_id];
+    int memory = 0;
+    Settle(vm.machine_id);
+    for(auto & task : tasks) {
+        {
+            ProfileScope profile(PROFILE_VM_ADD_TASK);
+            VM_AddTask(vm_id, task.first, task.second);
+        }
+        vm.active_tasks.push_back(task.first);
+        task_vm[task.first] = vm_id;
+        memory += int(GetTaskMemory(task.first));
+        backlog[vm.machine_id] += Work(vm.machine_id, task.first);
+        gpu_tasks[vm.machine_id] += Accelerated(vm.machine_id, task.first) ? 1 : 0;
+    }
+    machines[vm.machine_id].active_tasks += unsigned(tasks.size());
+    UpdateMemory(vm.machine_id, memory);
+    Reindex(vm.machine_id);
+}
+
+void Cluster::Attach(VMId_t vm_id, MachineId_t machine_id) {
+    {
+        ProfileScope profile(PROFILE_VM_ATTACH);
+        VM_Attach(vm_id, machine_id);
+    }
+    vms[vm_id].machine_id = machine_id;
+    AddVM(machine_id, vm_id);
+    machines[machine_id].active_vms++;
+    UpdateMemory(machine_id, VM_MEMORY_OVERHEAD);
+    Reindex(machine_id);
+}
+
+VMId_t Cluster::CreateVM(VMType_t vm_type, CPUType_t cpu) {
+    VMId_t vm_id = VM_Create(vm_type, cpu);
+    if(vm_id >= vms.size()) {
+        vms.resize(vm_id + 1);
+        migration_target.resize(vm_id + 1, NO_MACHINE);
+        migration_done_at.resize(vm_id + 1, 0);
+        migration_memory.resize(vm_id + 1, 0);
+    }
+    vms[vm_id] = VMInfo_t{ {}, cpu, NO_MACHINE, vm_id, vm_type };
+    return vm_id;
+}
+
+// The simulator takes the VM off the source machine as soon as the migration starts, but only releases
+// the VM overhead there: the memory of the tasks stays charged to the source machine. The destination
+// receives the VM and all of its memory once the migration completes, MIGRATION_TIME later whatever the size.
+void Cluster::Migrate(VMId_t vm_id, MachineId_t machine_id) {
+    {
+        ProfileScope profile(PROFILE_VM_MIGRATE);
+        VM_Migrate(vm_id, machine_id);
+    }
+    VMInfo_t & vm = vms[vm_id];
+    MachineInfo_t & from = machines[vm.machine_id];
+    Settle(vm.machine_id);
+    for(TaskId_t task_id : vm.active_tasks) {
+        backlog[vm.machine_id] -= min(backlog[vm.machine_id], Work(vm.machine_id, task_id));
+        gpu_tasks[vm.machine_id] -= Accelerated(vm.machine_id, task_id) ? 1 : 0;
+    }
+    from.active_tasks -= unsigned(vm.active_tasks.size());
+    from.active_vms--;
+    UpdateMemory(vm.machine_id, -VM_MEMORY_OVERHEAD);
+    RemoveVM(vm.machine_id, vm_id);
+    Reindex(vm.machine_id);
+    migration_target[vm_id] = machine_id;
+    incoming[machine_id]++;
+    migration_done_at[vm_id] = Now() + MIGRATION_TIME;
+    migration_memory[vm_id] = VMMemory(vm_id);
+    migrations++;
+    migrating_memory += migration_memory[vm_id];
+}
+
+// Machine_SetCorePerformance() sets every core of the machine whichever core it is given
+void Cluster::SetPerformance(MachineId_t machine_id, CPUPerformance_t p_state) {
+    if(machines[machine_id].p_state == p_state)
+        return;
+    {
+        ProfileScope profile(PROFILE_MACHINE_SET_PERFORMANCE);
+        Machine_SetCorePerformance(machine_id, 0, p_state);
+    }
+    Settle(machine_id);
+    machines[machine_id].p_state = p_state;
+}
+
+// The simulator may call StateChangeComplete() from inside Machine_SetState(), so the request is recorded first
+void Cluster::SetState(MachineId_t machine_id, MachineState_t s_state) {
+    MachineState_t current = machines[machine_id].s_state;
+    if(s_state == current)
+        setting_state = machine_id;
+    else {
+        requested_state[machine_id] = s_state;
+        ready_at[machine_id] = Now() + TransitionLatency(current, s_state);
+    }
+    {
+        ProfileScope profile(PROFILE_MACHINE_SET_STATE);
+        Machine_SetState(machine_id, s_state);
+    }
+    setting_state = NO_MACHINE;
+    Reindex(machine_id);
+}
+
+void Cluster::ShutdownVM(VMId_t vm_id) {
+    VM_Shutdown(vm_id);
+    VMInfo_t & vm = vms[vm_id];
+    if(vm.machine_id != NO_MACHINE) {
+        machines[vm.machine_id].active_vms--;
+        UpdateMemory(vm.machine_id, -VM_MEMORY_OVERHEAD);
+        RemoveVM(vm.machine_id, vm_id);
+        Reindex(vm.machine_id);
+        vm.machine_id = NO_MACHINE;
+    }
+}
+
+void Cluster::MigrationDone(VMId_t vm_id) {
+    VMInfo_t & vm = vms[vm_id];
+    MachineId_t next = migration_target[vm_id];
+    if(next == NO_MACHINE)
+        return;
+    int memory = VM_MEMORY_OVERHEAD;
+    Settle(next);
+    for(TaskId_t task_id : vm.active_tasks) {
+        memory += int(GetTaskMemory(task_id));
+        backlog[next] += Work(next, task_id);
+        gpu_tasks[next] += Accelerated(next, task_id) ? 1 : 0;
+    }
+    MachineInfo_t & to = machines[next];
+    to.active_tasks += unsigned(vm.active_tasks.size());
+    to.active_vms++;
+    UpdateMemory(next, memory);
+    AddVM(next, vm_id);
+    Reindex(next);
+    vm.machine_id = next;
+    migration_target[vm_id] = NO_MACHINE;
+    incoming[next]--;
+    migrations--;
+    migrating_memory -= migration_memory[vm_id];
+}
+
+void Cluster::StateChangeDone(MachineId_t machine_id) {
+    if(machine_id == setting_state)
+        return;
+    Settle(machine_id);
+    machines[machine_id].s_state = requested_state[machine_id];
+    Reindex(machine_id);
+}
+
+void Cluster::TaskDone(TaskId_t task_id) {
+    VMId_t vm_id = TaskVM(task_id);
+    if(vm_id == NO_VM)
+        return;
+    task_vm.erase(task_id);
+    VMInfo_t & vm = vms[vm_id];
+    auto it = find(vm.active_tasks.begin(), vm.active_tasks.end(), task_id);
+    if(it != vm.active_tasks.end()) {
+        *it = vm.active_tasks.back();
+        vm.active_tasks.pop_back();
+    }
+    if(migration_target[vm_id] == NO_MACHINE) {
+        Settle(vm.machine_id);
+        gpu_tasks[vm.machine_id] -= Accelerated(vm.machine_id, task_id) ? 1 : 0;
+        if(--machines[vm.machine_id].active_tasks == 0)
+            backlog[vm.machine_id] = 0;
+    }
+    UpdateMemory(vm.machine_id, -int(GetTaskMemory(task_id)));
+    Reindex(vm.machine_id);
+}
+
+void Cluster::AddVM(MachineId_t machine_id, VMId_t vm_id) {
+    const VMInfo_t & vm = vms[vm_id];
+    machine_vms[machine_id].push_back(vm_id);
+    if(typed_vms[machine_id][vm.vm_type] == NO_VM)
+        typed_vms[machine_id][vm.vm_type] = vm_id;
+    vm_count[vm.vm_type][vm.cpu]++;
+}
+
+void Cluster::RemoveVM(MachineId_t machine_id, VMId_t vm_id) {
+    const VMInfo_t & vm = vms[vm_id];
+    vector<VMId_t> & list = machine_vms[machine_id];
+    auto it = find(list.begin(), list.end(), vm_id);
+    if(it == list.end())
+        return;
+    list.erase(it);
+    vm_count[vm.vm_type][vm.cpu]--;
+    if(typed_vms[machine_id][vm.vm_type] != vm_id)
+        return;
+    typed_vms[machine_id][vm.vm_type] = NO_VM;
+    for(VMId_t other : list)
+        if(vms[other].vm_type == vm.vm_type) {
+            typed_vms[machine_id][vm.vm_type] = other;
+            break;
+        }
+}
+
+// A task with instructions left among tasks on the machine, which hold it back by shared instructions in all
+Time_t Cluster::Estimate(MachineId_t machine_id, uint64_t instructions, uint64_t shared, unsigned tasks, Time_t now) const {
+    const MachineInfo_t & info = machines[machine_id];
+    uint64_t mips = Mips(machine_id);
+    Time_t alone = (instructions + mips - 1) / mips;
+    if(tasks <= info.num_cpus)
+        return now + alone;
+    uint64_t capacity = mips * info.num_cpus;
+    return now + max(alone, (shared + capacity - 1) / capacity);
+}
+
+uint64_t Cluster::Longest(MachineId_t machine_id) const {
+    uint64_t longest = 0;
+    for(VMId_t vm_id : machine_vms[machine_id])
+        for(TaskId_t task_id : vms[vm_id].active_tasks)
+            longest = max(longest, Work(machine_id, task_id));
+    return longest;
+}
+
+uint64_t Cluster::Mips(MachineId_t machine_id) const {
+    const MachineInfo_t & info = machines[machine_id];
+    return max<uint64_t>(1, uint64_t(info.performance[info.p_state]) * 100 / Slowdown(machine_id));
+}
+
+uint64_t Cluster::Rate(MachineId_t machine_id) const {
+    const MachineInfo_t & info = machines[machine_id];
+    if(info.s_state != S0)
+        return 0;
+    return uint64_t(info.performance[info.p_state]) * min(info.active_tasks, info.num_cpus) * 100 / Slowdown(machine_id);
+}
+
+void Cluster::Reindex(MachineId_t machine_id) {
+    const MachineInfo_t & info = machines[machine_id];
+    if(index_bucket[machine_id] != NOT_INDEXED)
+        index[index_bucket[machine_id]].erase(index_key[machine_id]);
+    if(requested_state[machine_id] != info.s_state) {
+        index_bucket[machine_id] = NOT_INDEXED;
+        return;
+    }
+    index_bucket[machine_id] = Bucket(info.cpu, info.gpus, info.s_state);
+    index_key[machine_id] = IndexKey_t(Headroom(machine_id), info.active_tasks, machine_id);
+    index[index_bucket[machine_id]].insert(index_key[machine_id]);
+}
+
+void Cluster::Settle(MachineId_t machine_id) {
+    Time_t now = Now();
+    backlog[machine_id] = Backlog(machine_id, now);
+    backlog_at[machine_id] = now;
+}
+
+uint64_t Cluster::Shared(MachineId_t machine_id, uint64_t instructions) const {
+    uint64_t shared = 0;
+    for(VMId_t vm_id : machine_vms[machine_id])
+        for(TaskId_t task_id : vms[vm_id].active_tasks)
+            shared += min(Work(machine_id, task_id), instructions);
+    return shared;
+}
+
+uint64_t Cluster::Work(MachineId_t machine_id, TaskId_t task_id) const {
+    uint64_t remaining = GetTaskInfo(task_id).remaining_instructions;
+    return Accelerated(machine_id, task_id) ? remaining / GPU_SPEEDUP : remaining;
+}
+
+void Cluster::UpdateMemory(MachineId_t machine_id, int delta) {
+    unsigned before = machines[machine_id].memory_used;
+    unsigned after = unsigned(int(before) + delta);
+    if(SlowdownFor(before, machines[machine_id].memory_size) != SlowdownFor(after, machines[machine_id].memory_size))
+        Settle(machine_id);
+    machines[machine_id].memory_used = after;
+    if(pressure && (before > watermark[machine_id]) != (after > watermark[machine_id]))
+        pressure(machine_id, after > watermark[machine_id]);
+}
@@ -0,0 +1,170 @@
+//
+//  Cluster.hpp
+//  CloudSim
+//
+
+#ifndef Cluster_hpp
+#define Cluster_hpp
+
+#include <array>
+#include <functional>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "Interfaces.h"
+
+static const MachineId_t NO_MACHINE = MachineId_t(-1);
+static const VMId_t NO_VM = VMId_t(-1);
+
+#define TIMER_PERIOD 60000          // Simulator timer interval in us, S-state transitions advance once per tick
+#define MIGRATION_TIME 30000000     // Every migration takes this long in the simulator, in us
+#define GPU_SPEEDUP 20              // GPU-capable tasks run this much faster on a machine with GPUs, as in CPU::TaskRun()
+
+// Scheduler-side mirror of the machines and VMs. Machine_GetInfo() and VM_GetInfo() copy their vectors
+// on every call, so the static description of each machine is read once at Init() and the changing
+// fields are kept up to date from the operations the scheduler performs through this class.
+// All the read accessors return references or scalars and never allocate.
+//
+// The machines are also indexed in buckets by CPU type, GPU and S-state. Each bucket is ordered by
+// Headroom() and then by load, and is updated on every change, so placement queries take O(log n).
+// A machine with a state change in flight is left out of the index until StateChangeDone().
+//
+// S-state transitions take the simulator's table of timer ticks from the current state to the requested
+// one (see TransitionLatency()), so the time a machine will be ready is known when the change is asked for.
+// Asking for the state a machine is already in completes at once and leaves a transition in flight running.
+//
+// The instructions left on each machine are kept as a backlog that drains at the machine's MIPS on
+// min(active tasks, cores) cores, settled whenever the number of tasks changes. A task given a free core
+// is estimated to run alone. Under contention the cores are taken as shared evenly, so each task on the
+// machine holds a new one back by at most its own instructions; the machine drains no sooner than its
+// backlog over all the cores or its longest task alone. Those estimates walk the tasks on the machine and
+// ignore task priorities and the P-state changes to come. With CLOUDSIM_CHECK_ORACLE=1 the scheduler
+// checks them against the actual completions (make check-oracle).
+//
+// The VMs attached to each machine are also indexed by VMType_t, so the VM of a type on a machine is found
+// in O(1), and the VMs of each (VMType_t, CPUType_t) are counted. A migrating VM belongs to no machine.
+//
+// Every core of a machine with GPUs has its own GPU, and the simulator runs GPU-capable tasks on it
+// GPU_SPEEDUP times faster than their instructions at the core's MIPS. The backlog counts those at
+// CPU speed, so they weigh 1/GPU_SPEEDUP of their instructions, and GPUTasks() is the GPU occupancy.
+// The factor and the GPU power are fixed in the simulator; the machine class only says whether there are GPUs.
+//
+// Memory pressure is signalled before the simulator's MemoryWarning(): the callback given to
+// SetWatermark() runs whenever a machine's memory use crosses the watermark, up or down. Once a machine is
+// over its memory the simulator slows its tasks down 2x, and 4x past twice its memory; Slowdown() models
+// that and the completion oracle takes it into account.
+//
+// Note: energy_consumed in Info() is the value at Init(), use Machine_GetEnergy() for the current one.
+class Cluster {
+public:
+    Cluster()                                       {}
+    void Init();
+
+    // Read accessors
+    const MachineInfo_t & Info(MachineId_t machine_id) const        { return machines[machine_id]; }
+    unsigned MemoryFree(MachineId_t machine_id) const;
+    unsigned MemoryUsed(MachineId_t machine_id) const               { return machines[machine_id].memory_used; }
+    unsigned Headroom(MachineId_t machine_id) const;                // Memory left below the watermark
+    unsigned Slowdown(MachineId_t machine_id, unsigned extra_memory = 0) const;  // Percent, 100 when not overcommitted
+    unsigned ActiveTasks(MachineId_t machine_id) const              { return machines[machine_id].active_tasks; }
+    unsigned GPUTasks(MachineId_t machine_id) const                 { return gpu_tasks[machine_id]; }      // Running on its GPUs
+    bool Accelerated(MachineId_t machine_id, TaskId_t task_id) const { return machines[machine_id].gpus && IsTaskGPUCapable(task_id); }
+    MachineState_t SState(MachineId_t machine_id) const             { return machines[machine_id].s_state; }
+    CPUPerformance_t PState(MachineId_t machine_id) const           { return machines[machine_id].p_state; }
+    unsigned Total() const                                          { return unsigned(machines.size()); }
+    const VMInfo_t & VMInfo(VMId_t vm_id) const                     { return vms[vm_id]; }
+    const vector<TaskId_t> & VMActiveTasks(VMId_t vm_id) const      { return vms[vm_id].active_tasks; }
+    MachineId_t VMMachine(VMId_t vm_id) const                       { return vms[vm_id].machine_id; }
+    unsigned VMMemory(VMId_t vm_id) const;                          // Overhead plus the memory of its tasks
+    VMId_t TaskVM(TaskId_t task_id) const;                          // NO_VM once the task is done
+    MachineState_t RequestedState(MachineId_t machine_id) const     { return requested_state[machine_id]; }
+    bool InTransition(MachineId_t machine_id) const                 { return requested_state[machine_id] != machines[machine_id].s_state; }
+    Time_t TimeToReady(MachineId_t machine_id, Time_t now) const;   // Until the transition in flight completes, 0 if none
+    static Time_t TransitionLatency(MachineState_t from, MachineState_t to);
+    bool Migrating(VMId_t vm_id) const                              { return migration_target[vm_id] != NO_MACHINE; }
+    MachineId_t MigrationTarget(VMId_t vm_id) const                 { return migration_target[vm_id]; }
+    unsigned Incoming(MachineId_t machine_id) const                 { return incoming[machine_id]; }   // Migrations in flight to it
+    Time_t MigrationDoneAt(VMId_t vm_id) const                      { return migration_done_at[vm_id]; }
+    unsigned Migrations() const                                     { return migrations; }
+    unsigned MigratingMemory() const                                { return migrating_memory; }   // Being copied right now
+    const vector<VMId_t> & MachineVMs(MachineId_t machine_id) const { return machine_vms[machine_id]; }
+    VMId_t MachineVM(MachineId_t machine_id, VMType_t vm_type) const { return typed_vms[machine_id][vm_type]; }  // NO_VM if none
+    unsigned VMCount(VMType_t vm_type, CPUType_t cpu) const         { return vm_count[vm_type][cpu]; }
+    static bool Compatible(VMType_t vm_type, CPUType_t cpu);        // The simulator refuses to create the others
+
+    // Completion oracle, times are absolute in us and instructions at CPU speed
+    uint64_t Backlog(MachineId_t machine_id, Time_t now) const;     // Instructions left on the machine
+    Time_t EstimateCompletion(MachineId_t machine_id, uint64_t instructions, Time_t now) const;   // For a task added now
+    Time_t EstimateTask(MachineId_t machine_id, TaskId_t task_id, Time_t now) const              { return EstimateCompletion(machine_id, Work(machine_id, task_id), now); }
+    Time_t EstimateRunning(MachineId_t machine_id, TaskId_t task_id, Time_t now) const;          // For a task already on the machine
+    Time_t ProjectedFinish(MachineId_t machine_id, Time_t now) const;                           // When the backlog drains
+
+    // Placement queries, NO_MACHINE if nothing matches. When gpu is false machines without GPUs are tried first.
+    // FindMachine() returns the least headroom that fits memory plus, with promised, the memory already
+    // promised to each machine (indexed by MachineId_t); it walks past the machines whose promises fill them.
+    MachineId_t FindMachine(CPUType_t cpu, unsigned memory, bool gpu, MachineState_t s_state = S0,
+                            const vector<unsigned> * promised = nullptr) const;
+    MachineId_t MostFree(CPUType_t cpu, bool gpu, MachineState_t s_state = S0) const;                   // Most headroom
+
+    // Calls pressure(machine_id, above) on every crossing of fraction * memory_size
+    void SetWatermark(double fraction, function<void(MachineId_t, bool)> pressure);
+
+    // Operations, each forwards to the simulator and updates the mirror
+    void AddTask(VMId_t vm_id, TaskId_t task_id, Priority_t priority);
+    void AddTasks(VMId_t vm_id, const vector<pair<TaskId_t, Priority_t>> & tasks);  // Reindexes once for the batch
+    void Attach(VMId_t vm_id, MachineId_t machine_id);
+    VMId_t CreateVM(VMType_t vm_type, CPUType_t cpu);
+    void Migrate(VMId_t vm_id, MachineId_t machine_id);
+    void SetPerformance(MachineId_t machine_id, CPUPerformance_t p_state);     // All cores, see Governor.hpp
+    void SetState(MachineId_t machine_id, MachineState_t s_state);
+    void ShutdownVM(VMId_t vm_id);
+
+    // Notifications from the simulator
+    void MigrationDone(VMId_t vm_id);
+    void StateChangeDone(MachineId_t machine_id);
+    void TaskDone(TaskId_t task_id);
+private:
+    typedef tuple<unsigned, unsigned, MachineId_t> IndexKey_t;    // Headroom, active tasks, machine
+
+    static unsigned Bucket(CPUType_t cpu, bool gpu, MachineState_t s_state);
+    void AddVM(MachineId_t machine_id, VMId_t vm_id);
+    Time_t Estimate(MachineId_t machine_id, uint64_t instructions, uint64_t shared, unsigned tasks, Time_t now) const;
+    void RemoveVM(MachineId_t machine_id, VMId_t vm_id);
+    uint64_t Longest(MachineId_t machine_id) const; // Most instructions left on one task at CPU speed
+    uint64_t Mips(MachineId_t machine_id) const;    // Per core, with the slowdown
+    uint64_t Rate(MachineId_t machine_id) const;    // Instructions per us
+    void Reindex(MachineId_t machine_id);
+    void Settle(MachineId_t machine_id);            // Drains the backlog up to Now()
+    uint64_t Shared(MachineId_t machine_id, uint64_t instructions) const;  // Sum over the tasks of min(left, instructions)
+    void UpdateMemory(MachineId_t machine_id, int delta);
+    uint64_t Work(MachineId_t machine_id, TaskId_t task_id) const;  // Remaining instructions at CPU speed
+
+    vector<MachineInfo_t> machines;
+    vector<MachineState_t> requested_state;         // Target of the transition in flight, s_state if there is none
+    vector<Time_t> ready_at;                        // When the transition in flight completes
+    MachineId_t setting_state = NO_MACHINE;         // SetState() to the current state, completing immediately
+    vector<VMInfo_t> vms;                           // Indexed by VMId_t, the simulator hands them out in order
+    vector<MachineId_t> migration_target;           // Destination of an ongoing migration, indexed by VMId_t
+    vector<Time_t> migration_done_at;
+    vector<unsigned> migration_memory;              // What each ongoing migration copies
+    vector<unsigned> incoming;                      // Ongoing migrations to each machine
+    unsigned migrations = 0;
+    unsigned migrating_memory = 0;
+    unordered_map<TaskId_t, VMId_t> task_vm;        // VM each task in flight was placed on, dropped on completion
+    vector<vector<VMId_t>> machine_vms;             // VMs attached to each machine
+    vector<array<VMId_t, VM_TYPES>> typed_vms;      // The first of machine_vms of each type
+    unsigned vm_count[VM_TYPES][CPU_TYPES] = {};
+    vector<uint64_t> backlog;                       // Instructions left on each machine at backlog_at
+    vector<Time_t> backlog_at;
+    vector<unsigned> gpu_tasks;
+    vector<unsigned> watermark;                     // Memory use that counts as pressure on each machine
+    function<void(MachineId_t, bool)> pressure;
+
+    vector<set<IndexKey_t>> index;                  // See Bucket()
+    vector<IndexKey_t> index_key;                   // Where each machine currently sits in the index
+    vector<unsigned> index_bucket;
+};
+
+#endif /* Cluster_hpp */
@@ -0,0 +1,101 @@
+//
+//  Governor.cpp
+//  CloudSim
+//
+
+#include <algorithm>
+
+#include "Governor.hpp"
+#include "Params.hpp"
+#include "SimLog.hpp"
+
+static const char * governor_names[GOVERNORS] = { "performance", "ondemand", "schedutil", "deadline" };
+
+void Governor::Init(Cluster & cluster) {
+    string name = Param_Get("GOVERNOR", governor_names[GOVERNOR_PERFORMANCE]);
+    auto it = find(governor_names, governor_names + GOVERNORS, name);
+    if(it == governor_names + GOVERNORS)
+        ThrowException("Governor::Init(): Unknown CLOUDSIM_GOVERNOR ", name);
+    type = GovernorType_t(it - governor_names);
+    up_threshold = Param_Get("GOVERNOR_UP_THRESHOLD", 0.8);
+    window = max(Param_Get("GOVERNOR_WINDOW", 5u), 1u);
+    cores.resize(cluster.Total());
+    samples.assign(cluster.Total(), vector<unsigned>(window, 0));
+    busy.assign(cluster.Total(), 0);
+    for(unsigned i = 0; i < cluster.Total(); i++)
+        cores[i] = cluster.Info(MachineId_t(i)).num_cpus;
+}
+
+double Governor::Utilization(MachineId_t machine_id) const {
+    return double(busy[machine_id]) / double(window * cores[machine_id]);
+}
+
+// The slowest P-state that delivers at least mips per core
+CPUPerformance_t Governor::SlowestFor(const Cluster & cluster, MachineId_t machine_id, double mips) const {
+    const vector<unsigned> & performance = cluster.Info(machine_id).performance;
+    for(unsigned p_state = P_STATES; p_state-- > P0; )
+        if(double(performance[p_state]) >= mips)
+            return CPUPerformance_t(p_state);
+    return P0;
+}
+
+// Each task needs its remaining instructions done by its target completion, at CPU speed (see GPU_SPEEDUP).
+// While there are more tasks than cores, they share the cores, so the cores also need the total work done by
+// the earliest target.
+CPUPerformance_t Governor::Deadline(const Cluster & cluster, MachineId_t machine_id, Time_t now) const {
+    double needed = 0, total = 0;
+    Time_t earliest = 0;
+    unsigned tasks = 0;
+    for(VMId_t vm_id : cluster.MachineVMs(machine_id))
+        for(TaskId_t task_id : cluster.VMActiveTasks(vm_id)) {
+            TaskInfo_t info = GetTaskInfo(task_id);
+            tasks++;
+            if(info.required_sla == SLA3)
+                continue;
+            if(info.target_completion <= now)
+                return P0;
+            Time_t slack = info.target_completion - now;
+            double work = double(info.remaining_instructions) / (cluster.Accelerated(machine_id, task_id) ? GPU_SPEEDUP : 1);
+            needed = max(needed, work / double(slack));
+            total += work;
+            earliest = earliest ? min(earliest, slack) : slack;
+        }
+    if(earliest && tasks > cores[machine_id])
+        needed = max(needed, total / double(earliest) / double(cores[machine_id]));
+    return SlowestFor(cluster, machine_id, needed * cluster.Slowdown(machine_id) / 100);
+}
+
+void Governor::Check(Cluster & cluster, Time_t now) {
+    if(type == GOVERNOR_PERFORMANCE)
+        return;
+    for(unsigned i = 0; i < cluster.Total(); i++) {
+        MachineId_t machine = MachineId_t(i);
+        unsigned sample = min(cluster.ActiveTasks(machine), cores[i]);
+        busy[i] += sample - samples[i][next];
+        samples[i][next] = sample;
+        if(cluster.SState(machine) != S0 || cluster.InTransition(machine))
+            continue;
+
+        double utilization = Utilization(machine);
+        unsigned top = cluster.Info(machine).performance[P0];
+        CPUPerformance_t p_state = P0;
+        switch(type) {
+            case GOVERNOR_ONDEMAND:
+                p_state = utilization >= up_threshold ? P0 : SlowestFor(cluster, machine, top * utilization / up_threshold);
+                break;
+            case GOVERNOR_SCHEDUTIL:
+                p_state = SlowestFor(cluster, machine, 1.25 * top * utilization);
+                break;
+            case GOVERNOR_DEADLINE:
+                p_state = Deadline(cluster, machine, now);
+                break;
+            default:
+                break;
+        }
+        if(p_state != cluster.PState(machine)) {
+            SimLog<4>("Governor::Check(): Machine ", machine, " to P", unsigned(p_state), " at utilization ", utilization);
+            cluster.SetPerformance(machine, p_state);
+        }
+    }
+    next = (next + 1) % window;
+}
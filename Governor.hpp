@@ -0,0 +1,46 @@
+//
+//  Governor.hpp
+//  CloudSim
+//
+
+#ifndef Governor_hpp
+#define Governor_hpp
+
+#include <vector>
+
+#include "Cluster.hpp"
+
+// DVFS governors, picked with CLOUDSIM_GOVERNOR and run on every periodic check over the running machines.
+// Machine_SetCorePerformance() sets all the cores of a machine at once, so the governors work per machine:
+// utilization is the fraction of the cores busy, averaged over the last CLOUDSIM_GOVERNOR_WINDOW checks.
+// The simulator re-rates the running tasks at its next timer tick.
+typedef enum {
+    GOVERNOR_PERFORMANCE,       // Leave every machine at P0
+    GOVERNOR_ONDEMAND,          // P0 above the up threshold, otherwise the slowest P-state that keeps below it
+    GOVERNOR_SCHEDUTIL,         // The slowest P-state with 1.25x the utilization in MIPS
+    GOVERNOR_DEADLINE           // The slowest P-state at which the tasks on the machine still meet target_completion
+} GovernorType_t;
+#define GOVERNORS 4
+
+class Governor {
+public:
+    Governor()                                      {}
+    void Init(Cluster & cluster);
+    void Check(Cluster & cluster, Time_t now);
+
+    GovernorType_t Type() const                     { return type; }
+    double Utilization(MachineId_t machine_id) const;
+private:
+    CPUPerformance_t Deadline(const Cluster & cluster, MachineId_t machine_id, Time_t now) const;
+    CPUPerformance_t SlowestFor(const Cluster & cluster, MachineId_t machine_id, double mips) const;
+
+    GovernorType_t type = GOVERNOR_PERFORMANCE;
+    double up_threshold = 0.8;
+    unsigned window = 5;
+    vector<unsigned> cores;
+    vector<vector<unsigned>> samples;               // Busy cores at each of the last window checks, a ring per machine
+    vector<unsigned> busy;                          // Sum of the samples
+    unsigned next = 0;                              // Slot in the rings for the next check
+};
+
+#endif /* Governor_hpp */
@@ -0,0 +1,123 @@
+//
+//  Metrics.cpp
+//  CloudSim
+//
+
+#include <algorithm>
+#include <chrono>
+
+#include "Metrics.hpp"
+#include "Params.hpp"
+#include "SimLog.hpp"
+
+#define WRITER_PERIOD_MS 100        // The writer drains the ring at least this often
+
+static_assert(sizeof(MetricsSample_t) == 64, "MetricsSample_t is written out as it is laid out");
+
+void Metrics::Start(const Cluster & cluster) {
+    file_name = Param_Get("METRICS", "");
+    if(file_name.empty())
+        return;
+    string format = Param_Get("METRICS_FORMAT", "csv");
+    if(format != "csv" && format != "binary")
+        ThrowException("Metrics::Start(): CLOUDSIM_METRICS_FORMAT must be csv or binary, not ", format);
+    binary = format == "binary";
+    interval = Time_t(max(Param_Get("METRICS_INTERVAL", 1000000u), 1u));
+    unsigned capacity = max(Param_Get("METRICS_BUFFER", 65536u), cluster.Total());
+    file.open(file_name, binary ? ios::out | ios::binary : ios::out);
+    if(!file)
+        ThrowException("Metrics::Start(): Could not write metrics to ", file_name);
+    if(binary)
+        file << "CLOUDSIM_METRICS 1\n";
+    else {
+        file << "time,machine,utilization,memory_used,s_state,p_state,tasks,waiting,energy_rate";
+        for(unsigned sla = SLA0; sla < NUM_SLAS; sla++)
+            file << ",sla" << sla;
+        file << '\n';
+    }
+    ring.Reserve(capacity);
+    last_energy.assign(cluster.Total(), 0);
+    for(unsigned i = 0; i < cluster.Total(); i++)
+        last_energy[i] = Machine_GetEnergy(MachineId_t(i));
+    enabled = true;
+    writer = thread(&Metrics::Write, this);
+}
+
+void Metrics::Sample(Time_t now, const Cluster & cluster, const RunStats & stats, const vector<vector<TaskId_t>> & waiting) {
+    double seconds = double(now - last_sample) / 1000000;
+    MetricsSample_t sample = {};
+    sample.time = now;
+    for(unsigned sla = SLA0; sla < NUM_SLAS; sla++)
+        sample.sla_violations[sla] = float(stats.ViolationRate(SLAType_t(sla)));
+    for(unsigned i = 0; i < cluster.Total(); i++) {
+        MachineId_t machine = MachineId_t(i);
+        const MachineInfo_t & info = cluster.Info(machine);
+        uint64_t energy = Machine_GetEnergy(machine);
+        sample.energy_rate = seconds > 0 ? double(energy - last_energy[i]) / seconds : 0.0;
+        last_energy[i] = energy;
+        sample.utilization = float(min(cluster.ActiveTasks(machine), info.num_cpus)) / float(max(info.num_cpus, 1u));
+        sample.machine_id = machine;
+        sample.memory_used = cluster.MemoryUsed(machine);
+        sample.tasks = cluster.ActiveTasks(machine);
+        sample.waiting = unsigned(waiting[i].size());
+        sample.s_state = uint8_t(cluster.SState(machine));
+        sample.p_state = uint8_t(cluster.PState(machine));
+        if(!ring.Push(sample))
+            dropped++;
+    }
+    if(ring.Size() * 2 >= ring.Capacity())
+        wake.notify_one();
+    last_sample = now;
+    next_sample = now + interval;
+}
+
+void Metrics::Stop() {
+    if(!enabled)
+        return;
+    Join();
+    enabled = false;
+    if(dropped)
+        SimLog<1>("Metrics::Stop(): Dropped ", dropped, " samples, the writer fell behind");
+    if(failed)
+        ThrowException("Metrics::Stop(): Could not write metrics to ", file_name);
+}
+
+void Metrics::Join() {
+    if(!writer.joinable())
+        return;
+    stopping = true;
+    wake.notify_one();
+    writer.join();
+    file.close();
+}
+
+void Metrics::Write() {
+    MetricsSample_t sample;
+    for(;;) {
+        {
+            unique_lock<mutex> guard(lock);
+            wake.wait_for(guard, chrono::milliseconds(WRITER_PERIOD_MS), [this] { return stopping || ring.Size() * 2 >= ring.Capacity(); });
+        }
+        // Samples pushed before stopping was set are still drained below
+        bool last = stopping;
+        while(ring.Pop(sample)) {
+            if(binary) {
+                file.write(reinterpret_cast<const char *>(&sample), sizeof(sample));
+                continue;
+            }
+            file << sample.time << ',' << sample.machine_id << ',' << sample.utilization << ',' << sample.memory_used << ','
+                 << unsigned(sample.s_state) << ',' << unsigned(sample.p_state) << ',' << sample.tasks << ',' << sample.waiting << ','
+                 << sample.energy_rate;
+            for(unsigned sla = SLA0; sla < NUM_SLAS; sla++)
+                file << ',' << sample.sla_violations[sla];
+            file << '\n';
+        }
+        if(!file)
+            failed = true;
+        if(last)
+            break;
+    }
+    file.flush();
+    if(!file)
+        failed = true;
+}
@@ -0,0 +1,104 @@
+//
+//  Metrics.hpp
+//  CloudSim
+//
+
+#ifndef Metrics_hpp
+#define Metrics_hpp
+
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Cluster.hpp"
+#include "RunStats.hpp"
+
+// One machine at one sample. The binary format is a "CLOUDSIM_METRICS 1\n" line followed by these records
+// as they are laid out in memory, little-endian on the machines the simulator runs on.
+typedef struct {
+    uint64_t time;                          // In us
+    double energy_rate;                     // Machine_GetEnergy() units per second since the previous sample
+    float utilization;                      // Fraction of the cores busy
+    float sla_violations[NUM_SLAS];         // Cluster-wide percentage so far, as in GetSLAReport()
+    uint32_t machine_id;
+    uint32_t memory_used;
+    uint32_t tasks;                         // Active tasks, the run queue of the cores
+    uint32_t waiting;                       // Tasks waiting for the machine to wake up
+    uint8_t s_state;
+    uint8_t p_state;
+    uint8_t reserved[10];
+} MetricsSample_t;
+
+// Bounded queue between one producer and one consumer. Push() fails rather than blocking when it is full.
+template <class T>
+class SampleRing {
+public:
+    void Reserve(size_t capacity)           { slots.resize(capacity + 1); }
+    size_t Capacity() const                 { return slots.size() - 1; }
+    size_t Size() const {
+        size_t t = tail.load(memory_order_acquire), h = head.load(memory_order_acquire);
+        return t >= h ? t - h : t + slots.size() - h;
+    }
+    bool Push(const T & item) {
+        size_t t = tail.load(memory_order_relaxed), next = t + 1 == slots.size() ? 0 : t + 1;
+        if(next == head.load(memory_order_acquire))
+            return false;
+        slots[t] = item;
+        tail.store(next, memory_order_release);
+        return true;
+    }
+    bool Pop(T & item) {
+        size_t h = head.load(memory_order_relaxed);
+        if(h == tail.load(memory_order_acquire))
+            return false;
+        item = slots[h];
+        head.store(h + 1 == slots.size() ? 0 : h + 1, memory_order_release);
+        return true;
+    }
+private:
+    vector<T> slots;
+    atomic<size_t> head{ 0 };               // Next slot to pop, written by the consumer
+    atomic<size_t> tail{ 0 };               // Next slot to push, written by the producer
+};
+
+// Time series of the machines, enabled by setting CLOUDSIM_METRICS to the file that receives it.
+// Every CLOUDSIM_METRICS_INTERVAL us (1 s by default, rounded up to the periodic checks) each machine is
+// sampled into a ring of CLOUDSIM_METRICS_BUFFER samples, and a writer thread streams the ring to the file
+// as CSV or, with CLOUDSIM_METRICS_FORMAT=binary, as MetricsSample_t records. The simulation never waits on
+// the file: samples that find the ring full are dropped and counted, and memory stays bounded.
+class Metrics {
+public:
+    Metrics()                                       {}
+    ~Metrics()                                      { Join(); }
+    void Start(const Cluster & cluster);
+    void Stop();                                    // Writes out what is left and closes the file
+
+    bool Due(Time_t now) const                      { return enabled && now >= next_sample; }
+    void Sample(Time_t now, const Cluster & cluster, const RunStats & stats, const vector<vector<TaskId_t>> & waiting);
+    uint64_t Dropped() const                        { return dropped; }
+private:
+    void Join();
+    void Write();                                   // The writer thread
+
+    bool enabled = false;
+    bool binary = false;
+    string file_name;
+    ofstream file;                                  // Only touched by the writer once it runs
+    Time_t interval = 1000000;
+    Time_t next_sample = 0;
+    Time_t last_sample = 0;
+    vector<uint64_t> last_energy;
+    uint64_t dropped = 0;
+
+    SampleRing<MetricsSample_t> ring;
+    thread writer;
+    mutex lock;
+    condition_variable wake;
+    atomic<bool> stopping{ false };
+    atomic<bool> failed{ false };
+};
+
+#endif /* Metrics_hpp */
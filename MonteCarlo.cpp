@@ -0,0 +1,184 @@
+//
+//  MonteCarlo.cpp
+//  CloudSim
+//
+//  Runs the same configuration under K workload seeds across a pool of threads and reports the mean
+//  and 95% confidence interval of the SLA violations and the energy. Run k rewrites every line of the
+//  input that starts with "Seed:" to seed + k * stride, so run 0 is the input as it is and the same K
+//  give the same runs. A stride that would take a seed past 32 bits is refused. The inputs go to a
+//  directory of this process's own under work_dir, removed after the runs.
+//  Like sweep, each run is its own simulator process; the parameters go through CLOUDSIM_ variables.
+//
+//  Usage: montecarlo [-k runs] [-j threads] [-s simulator] [-d work_dir] [-t stride] [name=value ...] input_file
+//
+
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "Runner.hpp"
+
+typedef struct {
+    string input;                           // The input with the seeds of this run
+    RunnerReport_t report;
+    double wall;
+    string error;
+} Sample_t;
+
+// Two-sided 95% Student t quantiles for 1..30 degrees of freedom, the normal one beyond
+static double TQuantile(size_t degrees) {
+    static const double quantiles[30] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    return degrees >= 1 && degrees <= 30 ? quantiles[degrees - 1] : 1.960;
+}
+
+// Writes the input with seed + offset on every Seed line. Returns an empty string on success, otherwise
+// a description of what went wrong.
+static string WriteSeeded(const string & input, const string & output, uint64_t offset) {
+    ifstream in(input);
+    if(!in)
+        return "could not read " + input;
+    ofstream out(output);
+    if(!out)
+        return "could not write " + output;
+    string line;
+    while(getline(in, line)) {
+        size_t key = line.find_first_not_of(" \t");
+        if(key != string::npos && line.compare(key, 5, "Seed:") == 0 && offset) {
+            size_t start = line.find_first_not_of(" \t", key + 5);
+            if(start != string::npos && isdigit(line[start])) {
+                size_t end = line.find_first_not_of("0123456789", start);
+                uint64_t seed = stoull(line.substr(start, end - start));
+                if(seed > UINT32_MAX || offset > UINT32_MAX - seed)
+                    return "seed " + to_string(seed) + " + " + to_string(offset) + " does not fit in 32 bits";
+                line = line.substr(0, start) + to_string(seed + offset) + (end == string::npos ? "" : line.substr(end));
+            }
+        }
+        out << line << '\n';
+    }
+    return out ? "" : "could not write " + output;
+}
+
+// Removes the inputs written for the runs and the directory that holds them
+static void RemoveInputs(const vector<Sample_t> & samples, const string & directory) {
+    for(const Sample_t & sample : samples)
+        if(!sample.input.empty())
+            unlink(sample.input.c_str());
+    rmdir(directory.c_str());
+}
+
+static void PrintStatistic(const string & name, const vector<double> & values, int precision) {
+    double sum = 0;
+    for(double value : values)
+        sum += value;
+    double mean = sum / double(values.size()), squares = 0;
+    for(double value : values)
+        squares += (value - mean) * (value - mean);
+    double deviation = values.size() > 1 ? sqrt(squares / double(values.size() - 1)) : 0.0;
+    double half = values.size() > 1 ? TQuantile(values.size() - 1) * deviation / sqrt(double(values.size())) : 0.0;
+    cout << left << setw(12) << name << right << fixed << setprecision(precision)
+         << setw(14) << mean << setw(14) << deviation << setw(14) << mean - half << setw(14) << mean + half << endl;
+}
+
+int main(int argc, char * argv[]) {
+    unsigned runs = 10;
+    unsigned threads = thread::hardware_concurrency();
+    string simulator = "./simulator";
+    string directory = "/tmp";
+    uint64_t stride = 7919;
+    vector<string> environment;
+    int arg = 1;
+    for(; arg < argc - 1; arg++) {
+        string option = argv[arg];
+        if(option == "-k" && arg + 1 < argc - 1)
+            runs = unsigned(stoul(argv[++arg]));
+        else if(option == "-j" && arg + 1 < argc - 1)
+            threads = unsigned(stoul(argv[++arg]));
+        else if(option == "-s" && arg + 1 < argc - 1)
+            simulator = argv[++arg];
+        else if(option == "-d" && arg + 1 < argc - 1)
+            directory = argv[++arg];
+        else if(option == "-t" && arg + 1 < argc - 1)
+            stride = stoull(argv[++arg]);
+        else if(option.find('=') != string::npos && option[0] != '=') {
+            string name = option.substr(0, option.find('='));
+            for(char & c : name)
+                c = char(toupper(c));
+            environment.push_back("CLOUDSIM_" + name + option.substr(option.find('=')));
+        }
+        else
+            break;
+    }
+    if(argc - arg != 1 || runs == 0 || stride > UINT32_MAX) {
+        cerr << "Usage: " << argv[0] << " [-k runs] [-j threads] [-s simulator] [-d work_dir] [-t stride] [name=value ...] input_file" << endl;
+        return 1;
+    }
+    string input = argv[arg];
+
+    string work = directory + "/montecarlo_XXXXXX";
+    if(mkdtemp(&work[0]) == nullptr) {
+        cerr << "montecarlo: Could not create a directory in " << directory << endl;
+        return 1;
+    }
+    vector<Sample_t> samples(runs);
+    for(unsigned k = 0; k < runs; k++) {
+        samples[k].input = work + "/" + to_string(k) + ".md";
+        string error = WriteSeeded(input, samples[k].input, uint64_t(k) * stride);
+        if(!error.empty()) {
+            cerr << "montecarlo: Run " << k << ": " << error << endl;
+            RemoveInputs(samples, work);
+            return 1;
+        }
+    }
+
+    atomic<size_t> next(0);
+    vector<thread> pool;
+    for(unsigned i = 0; i < max(1u, min(threads, runs)); i++)
+        pool.emplace_back([&]() {
+            for(size_t job = next++; job < samples.size(); job = next++) {
+                string output;
+                Sample_t & sample = samples[job];
+                sample.error = Runner_Simulate(simulator, sample.input, environment, output, sample.wall);
+                if(sample.error.empty() && !Runner_ParseReport(output, sample.report))
+                    sample.error = "incomplete report";
+            }
+        });
+    for(thread & worker : pool)
+        worker.join();
+    RemoveInputs(samples, work);
+
+    vector<double> values[4];
+    double wall = 0;
+    for(unsigned k = 0; k < runs; k++) {
+        if(!samples[k].error.empty()) {
+            cerr << "montecarlo: Run " << k << " failed: " << samples[k].error << endl;
+            continue;
+        }
+        for(unsigned sla = 0; sla < 3; sla++)
+            values[sla].push_back(samples[k].report.sla[sla]);
+        values[3].push_back(samples[k].report.energy);
+        wall += samples[k].wall;
+    }
+    if(values[3].empty())
+        return 1;
+    cout << values[3].size() << " of " << runs << " runs, " << fixed << setprecision(3) << wall << " s of simulator time" << endl;
+    cout << left << setw(12) << "Metric" << right << setw(14) << "Mean" << setw(14) << "Std dev"
+         << setw(14) << "95% CI low" << setw(14) << "95% CI high" << endl;
+    PrintStatistic("SLA0 %", values[0], 4);
+    PrintStatistic("SLA1 %", values[1], 4);
+    PrintStatistic("SLA2 %", values[2], 4);
+    PrintStatistic("Energy KWh", values[3], 6);
+    return values[3].size() == runs ? 0 : 1;
+}
@@ -0,0 +1,45 @@
+//
+//  Params.cpp
+//  CloudSim
+//
+
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+#include "Interfaces.h"
+#include "Params.hpp"
+
+static const char * Lookup(const string & name) {
+    return getenv(("CLOUDSIM_" + name).c_str());
+}
+
+double Param_Get(const string & name, double default_value) {
+    const char * value = Lookup(name);
+    if(value == nullptr)
+        return default_value;
+    char * end;
+    double result = strtod(value, &end);
+    if(end == value || *end != '\0')
+        ThrowException("Param_Get(): Expected a number for CLOUDSIM_" + name + " but found ", value);
+    return result;
+}
+
+string Param_Get(const string & name, const char * default_value) {
+    const char * value = Lookup(name);
+    return value == nullptr ? default_value : value;
+}
+
+unsigned Param_Get(const string & name, unsigned default_value) {
+    const char * value = Lookup(name);
+    if(value == nullptr)
+        return default_value;
+    // strtoul() would take "-1" as ULONG_MAX, so a sign is refused along with anything past 32 bits
+    char * end;
+    errno = 0;
+    unsigned long result = strtoul(value, &end, 10);
+    if(end == value || *end != '\0' || strchr(value, '-') != nullptr || errno == ERANGE || result > UINT_MAX)
+        ThrowException("Param_Get(): Expected an unsigned integer for CLOUDSIM_" + name + " but found ", value);
+    return unsigned(result);
+}
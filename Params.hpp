@@ -0,0 +1,20 @@
+//
+//  Params.hpp
+//  CloudSim
+//
+
+#ifndef Params_hpp
+#define Params_hpp
+
+#include <string>
+
+#include "SimTypes.h"
+
+// Tuning knobs for the scheduler. The simulator's command line is fixed, so each parameter NAME is read
+// from the environment variable CLOUDSIM_NAME, falling back to the given default when it is not set.
+// A value that does not parse is reported through ThrowException().
+extern double           Param_Get(const string & name, double default_value);
+extern string           Param_Get(const string & name, const char * default_value);
+extern unsigned         Param_Get(const string & name, unsigned default_value);
+
+#endif /* Params_hpp */
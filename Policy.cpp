@@ -0,0 +1,196 @@
+//
+//  Policy.cpp
+//  CloudSim
+//
+
+#include <type_traits>
+
+#include "Params.hpp"
+#include "Policy.hpp"
+#include "SimLog.hpp"
+
+// Machines that can take a task right now
+static bool Running(const Cluster & cluster, MachineId_t machine_id, CPUType_t cpu) {
+    return cluster.Info(machine_id).cpu == cpu && cluster.SState(machine_id) == S0 && !cluster.InTransition(machine_id);
+}
+
+VMId_t Policy_VMOn(PolicyContext_t & context, MachineId_t machine_id, VMType_t vm_type) {
+    Cluster & cluster = context.cluster;
+    if(!Running(cluster, machine_id, cluster.Info(machine_id).cpu))
+        return NO_VM;
+    VMId_t vm_id = cluster.MachineVM(machine_id, vm_type);
+    if(vm_id != NO_VM)
+        return vm_id;
+    vm_id = cluster.CreateVM(vm_type, cluster.Info(machine_id).cpu);
+    cluster.Attach(vm_id, machine_id);
+    context.vms.push_back(vm_id);
+    return vm_id;
+}
+
+VMId_t Policy_Fallback(const PolicyContext_t & context, TaskId_t task_id) {
+    const Cluster & cluster = context.cluster;
+    CPUType_t cpu = RequiredCPUType(task_id);
+    VMType_t vm_type = RequiredVMType(task_id);
+    size_t first = task_id % context.active_machines;
+    for(bool matching : { true, false })
+        for(size_t i = 0; i < context.vms.size(); i++) {
+            VMId_t vm_id = context.vms[(first + i) % context.vms.size()];
+            const VMInfo_t & info = cluster.VMInfo(vm_id);
+            if(matching && (info.cpu != cpu || info.vm_type != vm_type))
+                continue;
+            if(info.machine_id != NO_MACHINE && !cluster.Migrating(vm_id) && Running(cluster, info.machine_id, info.cpu))
+                return vm_id;
+        }
+    return context.vms[first];
+}
+
+MachineId_t Policy_GPUHost(const PolicyContext_t & context, TaskId_t task_id, unsigned memory) {
+    if(!context.gpu_steering || !IsTaskGPUCapable(task_id))
+        return NO_MACHINE;
+    const Cluster & cluster = context.cluster;
+    CPUType_t cpu = RequiredCPUType(task_id);
+    MachineId_t best = NO_MACHINE;
+    for(unsigned i = 0; i < cluster.Total(); i++) {
+        MachineId_t machine = MachineId_t(i);
+        const MachineInfo_t & info = cluster.Info(machine);
+        if(!info.gpus || !Running(cluster, machine, cpu) || cluster.Headroom(machine) < memory + context.promised[machine])
+            continue;
+        // Fewer GPU tasks per core, compared without dividing
+        if(best == NO_MACHINE || uint64_t(cluster.GPUTasks(machine)) * cluster.Info(best).num_cpus < uint64_t(cluster.GPUTasks(best)) * info.num_cpus)
+            best = machine;
+    }
+    return best;
+}
+
+VMId_t RoundRobinPolicy::Place(PolicyContext_t & context, TaskId_t task_id, unsigned memory) {
+    Cluster & cluster = context.cluster;
+    CPUType_t cpu = RequiredCPUType(task_id);
+    VMType_t vm_type = RequiredVMType(task_id);
+    MachineId_t host = Policy_GPUHost(context, task_id, memory);
+    if(host != NO_MACHINE)
+        return Policy_VMOn(context, host, vm_type);
+    VMId_t vm = cluster.Migrations() && !context.spread_migrating ? context.vms[0] : context.vms[task_id % context.active_machines];
+    MachineId_t machine = cluster.VMMachine(vm);
+    const VMInfo_t & info = cluster.VMInfo(vm);
+    if(info.cpu != cpu || info.vm_type != vm_type || !Running(cluster, machine, cpu) || cluster.Headroom(machine) < memory + context.promised[machine]) {
+        machine = cluster.FindMachine(cpu, memory, false, S0, &context.promised);
+        VMId_t found = machine != NO_MACHINE ? Policy_VMOn(context, machine, vm_type) : NO_VM;
+        if(found != NO_VM)
+            vm = found;
+    }
+    return vm;
+}
+
+
+MachineId_t FirstFitPolicy::Pick(PolicyContext_t & context, CPUType_t cpu, unsigned memory) {
+    for(unsigned i = 0; i < context.cluster.Total(); i++)
+        if(Running(context.cluster, MachineId_t(i), cpu) && Fits(context, MachineId_t(i), memory))
+            return MachineId_t(i);
+    return NO_MACHINE;
+}
+
+MachineId_t BestFitPolicy::Pick(PolicyContext_t & context, CPUType_t cpu, unsigned memory) {
+    return context.cluster.FindMachine(cpu, memory, false, S0, &context.promised);
+}
+
+static const char * s_state_names[S_STATES] = { "S0", "S0i1", "S1", "S2", "S3", "S4", "S5" };
+
+void EnergyGreedyPolicy::Init(PolicyContext_t & context) {
+    idle_checks = max(Param_Get("IDLE_CHECKS", 5u), 1u);
+    string name = Param_Get("IDLE_STATE", s_state_names[S3]);
+    auto it = find(s_state_names + S0i1, s_state_names + S_STATES, name);
+    if(it == s_state_names + S_STATES)
+        ThrowException("EnergyGreedyPolicy::Init(): CLOUDSIM_IDLE_STATE is not a sleep state: ", name);
+    idle_state = MachineState_t(it - s_state_names);
+    idle_since.assign(context.cluster.Total(), 0);
+}
+
+MachineId_t EnergyGreedyPolicy::Pick(PolicyContext_t & context, CPUType_t cpu, unsigned memory) {
+    const Cluster & cluster = context.cluster;
+    MachineId_t busiest = NO_MACHINE;
+    for(unsigned i = 0; i < cluster.Total(); i++) {
+        MachineId_t machine = MachineId_t(i);
+        if(!Running(cluster, machine, cpu) || !Fits(context, machine, memory) || cluster.ActiveTasks(machine) >= cluster.Info(machine).num_cpus)
+            continue;
+        if(busiest == NO_MACHINE || cluster.ActiveTasks(machine) > cluster.ActiveTasks(busiest))
+            busiest = machine;
+    }
+    if(busiest != NO_MACHINE)
+        return busiest;
+    return cluster.FindMachine(cpu, memory, false, S0, &context.promised);
+}
+
+void EnergyGreedyPolicy::Check(PolicyContext_t & context, Time_t now) {
+    Cluster & cluster = context.cluster;
+    unsigned awake[CPU_TYPES] = {};
+    unsigned free_cores[CPU_TYPES] = {};
+    unsigned queued[CPU_TYPES] = {};                // Tasks beyond the cores of their machines
+    unsigned coming[CPU_TYPES] = {};                // Cores of the machines waking up
+    for(unsigned i = 0; i < cluster.Total(); i++) {
+        MachineId_t machine = MachineId_t(i);
+        const MachineInfo_t & info = cluster.Info(machine);
+        unsigned active = cluster.ActiveTasks(machine);
+        if(cluster.InTransition(machine))
+            coming[info.cpu] += cluster.RequestedState(machine) == S0 ? info.num_cpus : 0;
+        else if(info.s_state == S0) {
+            awake[info.cpu]++;
+            free_cores[info.cpu] += info.num_cpus - min(active, info.num_cpus);
+            queued[info.cpu] += active - min(active, info.num_cpus);
+        }
+    }
+    // With every core of a CPU type busy, machines of that type come back from the shallowest sleep state
+    // until the cores on their way cover the tasks queued beyond the cores
+    for(unsigned cpu = 0; cpu < CPU_TYPES; cpu++) {
+        for(unsigned s_state = S0i1; free_cores[cpu] == 0 && coming[cpu] < max(queued[cpu], 1u) && s_state < S_STATES; ) {
+            MachineId_t machine = cluster.FindMachine(CPUType_t(cpu), 0, false, MachineState_t(s_state));
+            if(machine == NO_MACHINE) {
+                s_state++;
+                continue;
+            }
+            SimLog<3>("EnergyGreedyPolicy::Check(): No free core left, waking machine ", machine, " from ", s_state_names[s_state], " at ", now);
+            cluster.SetState(machine, S0);
+            idle_since[machine] = 0;
+            coming[cpu] += cluster.Info(machine).num_cpus;
+        }
+    }
+    for(unsigned i = 0; i < cluster.Total(); i++) {
+        MachineId_t machine = MachineId_t(i);
+        CPUType_t cpu = cluster.Info(machine).cpu;
+        if(!Running(cluster, machine, cpu) || cluster.ActiveTasks(machine) > 0 || context.promised[machine] > 0) {
+            idle_since[machine] = 0;
+            continue;
+        }
+        if(idle_since[machine] == 0)
+            idle_since[machine] = now;
+        if(now - idle_since[machine] < Time_t(idle_checks - 1) * TIMER_PERIOD || awake[cpu] <= 1)
+            continue;
+        if(cluster.Incoming(machine))
+            continue;
+        SimLog<3>("EnergyGreedyPolicy::Check(): Machine ", machine, " is idle, sending it to ", s_state_names[idle_state], " at ", now);
+        cluster.SetState(machine, idle_state);
+        awake[cpu]--;
+        idle_since[machine] = 0;
+    }
+}
+
+template <class Policy>
+static bool Make(Policy_t & policy, const string & name, const char * policy_name) {
+    if constexpr(is_constructible_v<Policy_t, Policy>) {
+        if(name == policy_name) {
+            policy = Policy();
+            return true;
+        }
+    }
+    return false;
+}
+
+Policy_t Policy_Create() {
+    string name = Param_Get("POLICY", "");
+    Policy_t policy;                        // The first policy compiled in when none is named
+    if(name.empty())
+        return policy;
+    if(!Make<RoundRobinPolicy>(policy, name, "roundrobin") && !Make<FirstFitPolicy>(policy, name, "firstfit") &&
+       !Make<BestFitPolicy>(policy, name, "bestfit") && !Make<EnergyGreedyPolicy>(policy, name, "energy"))
+        ThrowException("Policy_Create(): Unknown or compiled out CLOUDSIM_POLICY ", name);
+    return policy;
+}
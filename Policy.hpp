@@ -0,0 +1,121 @@
+//
+//  Policy.hpp
+//  CloudSim
+//
+
+#ifndef Policy_hpp
+#define Policy_hpp
+
+#include <variant>
+#include <vector>
+
+#include "Cluster.hpp"
+
+// Placement policies. The scheduler keeps every policy in a variant and dispatches with visit(), so the
+// chosen policy's hooks are called directly and can be inlined, with no virtual calls. The policy is
+// picked at Init() from CLOUDSIM_POLICY (roundrobin, firstfit, bestfit or energy). Build with e.g.
+// -DSIM_POLICY=BestFitPolicy to compile in that one policy only.
+//
+// Every policy provides
+//      void Init(PolicyContext_t & context)
+//      VMId_t Place(PolicyContext_t & context, TaskId_t task_id, unsigned memory)
+//      void Check(PolicyContext_t & context, Time_t now)
+// Place() only chooses the VM; the scheduler adds the task and handles batching and waking machines up.
+// With CLOUDSIM_GPU_STEERING set, every policy first offers GPU-capable tasks to Policy_GPUHost().
+
+// What the policies see of the scheduler
+typedef struct {
+    Cluster & cluster;
+    vector<VMId_t> & vms;                   // The first active_machines are the round robin, created ones are appended
+    unsigned active_machines;
+    const vector<unsigned> & promised;      // Memory promised on each machine by the batch being placed
+    bool spread_migrating;                  // Keep the round robin while VMs migrate instead of using vms[0]
+    bool gpu_steering;                      // Place GPU-capable tasks on machines with GPUs when one has room
+} PolicyContext_t;
+
+// The VM of the given type on the machine, found in O(1) through Cluster::MachineVM(). When there is none
+// one is created, attached and appended to vms, and stays there warm for the next tasks of its type.
+// NO_VM when the machine is not in S0 or has a state change in flight.
+extern VMId_t           Policy_VMOn(PolicyContext_t & context, MachineId_t machine_id, VMType_t vm_type);
+
+// For a task no machine has room for: its round robin VM, or the first VM after it in vms of the task's CPU
+// and VM types on a running machine, skipping VMs that are migrating. Without one, the first such VM of any
+// type, and the round robin VM whatever its machine only when no VM is on a running machine.
+extern VMId_t           Policy_Fallback(const PolicyContext_t & context, TaskId_t task_id);
+
+// The running machine with GPUs and room for a GPU-capable task that has the fewest tasks on its GPUs per
+// core, or NO_MACHINE. Always NO_MACHINE without gpu_steering or for tasks that cannot use a GPU.
+extern MachineId_t      Policy_GPUHost(const PolicyContext_t & context, TaskId_t task_id, unsigned memory);
+
+// Round robin over the first active_machines VMs, falling back to the tightest fit when the choice is full
+// or does not match the task's CPU and VM types
+class RoundRobinPolicy {
+public:
+    void Init(PolicyContext_t & context)                                    {}
+    VMId_t Place(PolicyContext_t & context, TaskId_t task_id, unsigned memory);
+    void Check(PolicyContext_t & context, Time_t now)                       {}
+};
+
+// Base for the policies that pick a machine: Derived::Pick() returns a running machine of the task's CPU
+// type with room for it, or NO_MACHINE, and Place() turns that into a VM on the machine, creating one if
+// needed. When nothing fits the task goes to the running machine with the most headroom, then to Policy_Fallback().
+template <class Derived>
+class MachinePolicy {
+public:
+    void Init(PolicyContext_t & context)                                    {}
+    VMId_t Place(PolicyContext_t & context, TaskId_t task_id, unsigned memory) {
+        CPUType_t cpu = RequiredCPUType(task_id);
+        MachineId_t machine = Policy_GPUHost(context, task_id, memory);
+        if(machine == NO_MACHINE)
+            machine = static_cast<Derived *>(this)->Pick(context, cpu, memory);
+        if(machine == NO_MACHINE)
+            machine = context.cluster.MostFree(cpu, false);
+        VMId_t vm_id = machine != NO_MACHINE ? Policy_VMOn(context, machine, RequiredVMType(task_id)) : NO_VM;
+        return vm_id != NO_VM ? vm_id : Policy_Fallback(context, task_id);
+    }
+    void Check(PolicyContext_t & context, Time_t now)                       {}
+protected:
+    static bool Fits(const PolicyContext_t & context, MachineId_t machine_id, unsigned memory) {
+        return context.cluster.Headroom(machine_id) >= memory + context.promised[machine_id];
+    }
+};
+
+// Lowest numbered machine with room
+class FirstFitPolicy : public MachinePolicy<FirstFitPolicy> {
+public:
+    MachineId_t Pick(PolicyContext_t & context, CPUType_t cpu, unsigned memory);
+};
+
+// Machine with the least headroom that still has room, from the cluster index
+class BestFitPolicy : public MachinePolicy<BestFitPolicy> {
+public:
+    MachineId_t Pick(PolicyContext_t & context, CPUType_t cpu, unsigned memory);
+};
+
+// Packs tasks onto the busiest machines that have a free core and room, and sends machines that have
+// been idle for CLOUDSIM_IDLE_CHECKS timer periods to the sleep state named by CLOUDSIM_IDLE_STATE (S3 by
+// default), keeping at least one machine per CPU type up. Idle time is measured from when a machine was
+// first seen idle, so checks skipped with CLOUDSIM_SKIP_IDLE_CHECKS do not stretch it. When no running
+// machine of a CPU type has a free core, sleeping machines of that type are woken, shallowest state first,
+// until the cores on their way cover the tasks queued beyond the cores.
+class EnergyGreedyPolicy : public MachinePolicy<EnergyGreedyPolicy> {
+public:
+    void Init(PolicyContext_t & context);
+    MachineId_t Pick(PolicyContext_t & context, CPUType_t cpu, unsigned memory);
+    void Check(PolicyContext_t & context, Time_t now);
+private:
+    unsigned idle_checks = 5;
+    MachineState_t idle_state = S3;
+    vector<Time_t> idle_since;              // When each machine was first seen idle, 0 while it is busy
+};
+
+#ifdef SIM_POLICY
+typedef variant<SIM_POLICY> Policy_t;
+#else
+typedef variant<RoundRobinPolicy, FirstFitPolicy, BestFitPolicy, EnergyGreedyPolicy> Policy_t;
+#endif
+
+// The policy named by CLOUDSIM_POLICY, reported through ThrowException() when it is unknown
+extern Policy_t         Policy_Create();
+
+#endif /* Policy_hpp */
@@ -0,0 +1,309 @@
+//
+//  Profile.cpp
+//  CloudSim
+//
+
+#include "Profile.hpp"
+
+#if SIM_PROFILE
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+
+#include <sys/resource.h>
+#ifdef SIM_PROFILE_RDTSC
+#include <x86intrin.h>
+#endif
+
+#include "Interfaces.h"
+#include "Params.hpp"
+
+#define HISTOGRAM_BUCKETS 64        // Bucket i holds the samples below 2^i ticks
+#define PROFILE_DEPTH 16            // Nesting of callbacks and simulator calls that is timed
+
+typedef struct {
+    uint64_t calls;
+    uint64_t ticks;
+    uint64_t max;
+    uint64_t histogram[HISTOGRAM_BUCKETS];
+} Timing_t;
+
+static const char * point_names[PROFILE_POINTS] = {
+    "new_task", "task_completion", "scheduler_check", "migration_done", "memory_warning", "sla_warning", "state_change",
+    "vm_add_task", "vm_attach", "vm_migrate", "machine_set_state", "machine_set_performance"
+};
+
+static bool enabled = false;
+static string report_file;
+static uint64_t started;
+static chrono::steady_clock::time_point started_clock;
+static uint64_t returned_at;                // When the outermost callback last returned to the simulator
+
+// The points in progress, innermost last. The simulator can call back into the scheduler from inside a
+// simulator call, e.g. MemoryWarning() from VM_AddTask(), so callbacks and calls nest to any depth.
+typedef struct {
+    ProfilePoint_t point;
+    uint64_t entered;
+    uint64_t nested;                        // Time spent in the points nested inside this one
+} Frame_t;
+static Frame_t frames[PROFILE_DEPTH];
+static unsigned depth = 0;                  // Frames past PROFILE_DEPTH are not timed
+
+static Timing_t own[PROFILE_POINTS];        // Own time of the callbacks and of the simulator calls
+static Timing_t simulator[PROFILE_CALLBACKS];
+
+#ifdef SIM_PROFILE_ALLOC
+typedef struct {
+    uint64_t allocations;
+    uint64_t bytes;
+} Allocations_t;
+
+static thread_local bool counting = false;  // Only the main thread is counted
+static Allocations_t own_allocations[PROFILE_POINTS];
+static Allocations_t simulator_allocations[PROFILE_CALLBACKS];
+static Allocations_t pending;               // Since the outermost callback last returned
+static Allocations_t * charged = &pending;  // Where the next allocation goes, the innermost point in progress
+
+static inline void Count(size_t size) {
+    if(counting) {
+        charged->allocations++;
+        charged->bytes += size;
+    }
+}
+
+static void * Allocate(size_t size, size_t alignment) {
+    void * pointer = nullptr;
+    if(alignment <= alignof(max_align_t))
+        pointer = malloc(size ? size : 1);
+    else if(posix_memalign(&pointer, alignment, size ? size : 1) != 0)
+        pointer = nullptr;
+    return pointer;
+}
+
+// Every replaceable form of new and delete, so nothing the standard library allocates escapes the count
+void * operator new(size_t size) {
+    Count(size);
+    void * pointer = Allocate(size, 0);
+    if(pointer == nullptr)
+        throw bad_alloc();
+    return pointer;
+}
+
+void * operator new(size_t size, align_val_t alignment) {
+    Count(size);
+    void * pointer = Allocate(size, size_t(alignment));
+    if(pointer == nullptr)
+        throw bad_alloc();
+    return pointer;
+}
+
+void * operator new(size_t size, const nothrow_t &) noexcept {
+    Count(size);
+    return Allocate(size, 0);
+}
+
+void * operator new(size_t size, align_val_t alignment, const nothrow_t &) noexcept {
+    Count(size);
+    return Allocate(size, size_t(alignment));
+}
+
+void * operator new[](size_t size)                                                      { return operator new(size); }
+void * operator new[](size_t size, align_val_t alignment)                               { return operator new(size, alignment); }
+void * operator new[](size_t size, const nothrow_t & tag) noexcept                      { return operator new(size, tag); }
+void * operator new[](size_t size, align_val_t alignment, const nothrow_t & tag) noexcept { return operator new(size, alignment, tag); }
+
+void operator delete(void * pointer) noexcept                                           { free(pointer); }
+void operator delete[](void * pointer) noexcept                                         { free(pointer); }
+void operator delete(void * pointer, size_t) noexcept                                   { free(pointer); }
+void operator delete[](void * pointer, size_t) noexcept                                 { free(pointer); }
+void operator delete(void * pointer, align_val_t) noexcept                              { free(pointer); }
+void operator delete[](void * pointer, align_val_t) noexcept                            { free(pointer); }
+void operator delete(void * pointer, size_t, align_val_t) noexcept                      { free(pointer); }
+void operator delete[](void * pointer, size_t, align_val_t) noexcept                    { free(pointer); }
+void operator delete(void * pointer, const nothrow_t &) noexcept                        { free(pointer); }
+void operator delete[](void * pointer, const nothrow_t &) noexcept                      { free(pointer); }
+void operator delete(void * pointer, align_val_t, const nothrow_t &) noexcept           { free(pointer); }
+void operator delete[](void * pointer, align_val_t, const nothrow_t &) noexcept         { free(pointer); }
+
+// An outermost callback takes over what was allocated in the simulator since the previous one returned
+static inline void ChargeEvent(ProfilePoint_t point) {
+    simulator_allocations[point].allocations += pending.allocations;
+    simulator_allocations[point].bytes += pending.bytes;
+    pending = Allocations_t{ 0, 0 };
+}
+
+// Points past PROFILE_DEPTH allocate on behalf of the innermost one that is timed
+static inline void ChargeTop() {
+    charged = depth == 0 ? &pending : &own_allocations[frames[min(depth, unsigned(PROFILE_DEPTH)) - 1].point];
+}
+
+static void WriteAllocations(ostream & report, const string & name, const Allocations_t & allocations) {
+    report << name << "_allocations=" << allocations.allocations << '\n';
+    report << name << "_allocated_bytes=" << allocations.bytes << '\n';
+}
+#else
+static inline void ChargeEvent(ProfilePoint_t point)        {}
+static inline void ChargeTop()                              {}
+#endif
+
+static inline uint64_t Ticks() {
+#ifdef SIM_PROFILE_RDTSC
+    return __rdtsc();
+#else
+    return uint64_t(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+static inline void Record(Timing_t & timing, uint64_t ticks) {
+    timing.calls++;
+    timing.ticks += ticks;
+    if(ticks > timing.max)
+        timing.max = ticks;
+    unsigned bucket = ticks ? 64 - unsigned(__builtin_clzll(ticks)) : 0;
+    timing.histogram[bucket < HISTOGRAM_BUCKETS ? bucket : HISTOGRAM_BUCKETS - 1]++;
+}
+
+bool Profile_Enabled() {
+    return enabled;
+}
+
+void Profile_Start() {
+    report_file = Param_Get("PROFILE", "");
+    enabled = !report_file.empty();
+    started_clock = chrono::steady_clock::now();
+    started = returned_at = Ticks();
+#ifdef SIM_PROFILE_ALLOC
+    counting = enabled;
+#endif
+}
+
+void Profile_Enter(ProfilePoint_t point) {
+    uint64_t now = Ticks();
+    // Only an outermost callback follows time spent in the simulator's event loop
+    if(depth == 0 && point < PROFILE_CALLBACKS) {
+        Record(simulator[point], now - returned_at);
+        ChargeEvent(point);
+    }
+    if(depth < PROFILE_DEPTH)
+        frames[depth] = Frame_t{ point, now, 0 };
+    depth++;
+    ChargeTop();
+}
+
+void Profile_Leave(ProfilePoint_t point) {
+    uint64_t now = Ticks();
+    if(depth == 0)
+        return;
+    depth--;
+    ChargeTop();
+    if(depth >= PROFILE_DEPTH)
+        return;
+    const Frame_t & frame = frames[depth];
+    uint64_t elapsed = now - frame.entered;
+    Record(own[frame.point], elapsed - frame.nested);
+    if(depth > 0)
+        frames[depth - 1].nested += elapsed;
+    else
+        returned_at = now;
+}
+
+static uint64_t Nanoseconds(uint64_t ticks, double ns_per_tick) {
+    return uint64_t(llround(double(ticks) * ns_per_tick));
+}
+
+// Upper bound of the bucket that holds the given fraction of the samples
+static uint64_t Percentile(const Timing_t & timing, double fraction, double ns_per_tick) {
+    uint64_t target = uint64_t(double(timing.calls) * fraction), seen = 0;
+    for(unsigned i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += timing.histogram[i];
+        if(seen > target || seen == timing.calls)
+            return Nanoseconds(i ? uint64_t(1) << i : 0, ns_per_tick);
+    }
+    return Nanoseconds(timing.max, ns_per_tick);
+}
+
+static void WriteTiming(ostream & report, const string & name, const Timing_t & timing, double ns_per_tick) {
+    report << name << "_ns=" << Nanoseconds(timing.ticks, ns_per_tick) << '\n';
+    if(timing.calls == 0)
+        return;
+    report << name << "_p50_ns=" << Percentile(timing, 0.50, ns_per_tick) << '\n';
+    report << name << "_p99_ns=" << Percentile(timing, 0.99, ns_per_tick) << '\n';
+    report << name << "_max_ns=" << Nanoseconds(timing.max, ns_per_tick) << '\n';
+    report << name << "_histogram_ns=";
+    bool first = true;
+    for(unsigned i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        if(timing.histogram[i] == 0)
+            continue;
+        report << (first ? "" : ",") << Nanoseconds(i ? uint64_t(1) << i : 0, ns_per_tick) << ":" << timing.histogram[i];
+        first = false;
+    }
+    report << '\n';
+}
+
+void Profile_Report(Time_t time) {
+    if(!enabled)
+        return;
+#ifdef SIM_PROFILE_ALLOC
+    counting = false;
+#endif
+    uint64_t wall_ns = uint64_t(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - started_clock).count());
+    uint64_t ticks = Ticks() - started;
+    double ns_per_tick = ticks ? double(wall_ns) / double(ticks) : 1.0;
+
+    uint64_t callbacks = 0, scheduler_ticks = 0;
+    for(unsigned i = 0; i < PROFILE_CALLBACKS; i++) {
+        callbacks += own[i].calls;
+        scheduler_ticks += own[i].ticks;
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    ofstream file;
+    if(report_file != "-") {
+        file.open(report_file);
+        if(!file)
+            ThrowException("Profile_Report(): Could not write profile to ", report_file);
+    }
+    ostream & report = report_file == "-" ? cout : file;
+    report << "simulated_us=" << time << '\n';
+    report << "wall_ns=" << wall_ns << '\n';
+    report << "callbacks=" << callbacks << '\n';
+    report << "callbacks_per_sec=" << (wall_ns ? double(callbacks) * 1e9 / double(wall_ns) : 0.0) << '\n';
+    report << "scheduler_ns=" << Nanoseconds(scheduler_ticks, ns_per_tick) << '\n';
+    report << "peak_rss_kb=" << usage.ru_maxrss << '\n';
+    for(unsigned i = 0; i < PROFILE_POINTS; i++) {
+        string name = point_names[i];
+        report << name << ".calls=" << own[i].calls << '\n';
+        if(i < PROFILE_CALLBACKS) {
+            WriteTiming(report, name + ".scheduler", own[i], ns_per_tick);
+            WriteTiming(report, name + ".simulator", simulator[i], ns_per_tick);
+            report << name << ".simulator_ns_per_event=" << (simulator[i].calls ? Nanoseconds(simulator[i].ticks, ns_per_tick) / simulator[i].calls : 0) << '\n';
+        }
+        else
+            WriteTiming(report, name + ".simulator", own[i], ns_per_tick);
+#ifdef SIM_PROFILE_ALLOC
+        WriteAllocations(report, name + (i < PROFILE_CALLBACKS ? ".scheduler" : ".simulator"), own_allocations[i]);
+        if(i < PROFILE_CALLBACKS)
+            WriteAllocations(report, name + ".simulator", simulator_allocations[i]);
+#endif
+    }
+#ifdef SIM_PROFILE_ALLOC
+    uint64_t allocations = pending.allocations, bytes = pending.bytes;
+    for(unsigned i = 0; i < PROFILE_POINTS; i++) {
+        allocations += own_allocations[i].allocations + (i < PROFILE_CALLBACKS ? simulator_allocations[i].allocations : 0);
+        bytes += own_allocations[i].bytes + (i < PROFILE_CALLBACKS ? simulator_allocations[i].bytes : 0);
+    }
+    uint64_t tasks = own[PROFILE_NEW_TASK].calls;
+    report << "allocations=" << allocations << '\n';
+    report << "allocated_bytes=" << bytes << '\n';
+    report << "allocations_per_task=" << (tasks ? double(allocations) / double(tasks) : 0.0) << '\n';
+    report << "bytes_per_task=" << (tasks ? double(bytes) / double(tasks) : 0.0) << '\n';
+#endif
+    report.flush();
+}
+
+#endif /* SIM_PROFILE */
@@ -0,0 +1,79 @@
+//
+//  Profile.hpp
+//  CloudSim
+//
+
+#ifndef Profile_hpp
+#define Profile_hpp
+
+#include "SimTypes.h"
+
+// Build with -DSIM_PROFILE=0 to compile the profiler out of the callbacks entirely.
+// Build with -DSIM_PROFILE_RDTSC to take timestamps with rdtsc instead of steady_clock.
+// Build with -DSIM_PROFILE_ALLOC to also count heap allocations per point, see below.
+#ifndef SIM_PROFILE
+#define SIM_PROFILE 1
+#endif
+
+// Points the profiler measures. The callbacks also stand for the simulator event that caused them,
+// the simulator calls are the ones the scheduler makes through Cluster.
+typedef enum {
+    // Scheduler callbacks
+    PROFILE_NEW_TASK,
+    PROFILE_TASK_COMPLETION,
+    PROFILE_SCHEDULER_CHECK,
+    PROFILE_MIGRATION_DONE,
+    PROFILE_MEMORY_WARNING,
+    PROFILE_SLA_WARNING,
+    PROFILE_STATE_CHANGE,
+    // Simulator calls made from inside a callback
+    PROFILE_VM_ADD_TASK,            // Machine::TaskAdd and Machine::TaskRun
+    PROFILE_VM_ATTACH,
+    PROFILE_VM_MIGRATE,             // Machine::Migrate
+    PROFILE_MACHINE_SET_STATE,
+    PROFILE_MACHINE_SET_PERFORMANCE,
+} ProfilePoint_t;
+#define PROFILE_CALLBACKS 7
+#define PROFILE_POINTS 12
+
+// Profile of a run, enabled by setting CLOUDSIM_PROFILE to the file that receives the report ("-" for stdout).
+// Every point is counted and timed into a log2 latency histogram. A callback's own time excludes the
+// simulator calls it makes, and a simulator call's own time excludes the callbacks the simulator makes
+// from inside it, such as MemoryWarning() from VM_AddTask(). The time between the end of one outermost
+// callback and the start of the next is spent in the simulator and is charged to the event behind the
+// second callback; before scheduler_check that is the Machine::HandleTimer sweep. The report is written as
+// name=value lines at SimulationComplete(). Its callbacks count is the scheduler callbacks made, nested
+// ones included; events the simulator handles without calling the scheduler are not seen.
+//
+// With SIM_PROFILE_ALLOC (make profile-alloc) every form of the global operator new, aligned and nothrow
+// included, is replaced by one that counts the allocations and bytes made on the main thread, the
+// simulator's included, and charges them the same way as the time: to the innermost callback or simulator
+// call they happen in, and between callbacks to the event behind the next one.
+// The report adds allocations and bytes per point and per task, so a steady state that allocates nothing
+// shows up as zeros. Allocations made before InitScheduler() are not counted.
+#if SIM_PROFILE
+extern bool             Profile_Enabled();
+extern void             Profile_Enter(ProfilePoint_t point);
+extern void             Profile_Leave(ProfilePoint_t point);
+extern void             Profile_Report(Time_t time);
+extern void             Profile_Start();
+
+// Times one point for as long as it is in scope
+class ProfileScope {
+public:
+    ProfileScope(ProfilePoint_t point) : point(point)   { if(Profile_Enabled()) Profile_Enter(point); }
+    ~ProfileScope()                                     { if(Profile_Enabled()) Profile_Leave(point); }
+private:
+    ProfilePoint_t point;
+};
+#else
+inline void             Profile_Report(Time_t time)     {}
+inline void             Profile_Start()                 {}
+
+class ProfileScope {
+public:
+    ProfileScope(ProfilePoint_t point)                  {}
+};
+#endif
+
+#endif /* Profile_hpp */
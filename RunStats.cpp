@@ -0,0 +1,71 @@
+//
+//  RunStats.cpp
+//  CloudSim
+//
+
+#include <algorithm>
+
+#include "RunStats.hpp"
+
+void RunStats::TaskCompleted(Time_t now, TaskId_t task_id, bool accelerated) {
+    TaskInfo_t info = GetTaskInfo(task_id);
+    SLAType_t sla = info.required_sla;
+    Time_t late = now > info.target_completion ? now - info.target_completion : 0;
+    completed[sla]++;
+    if(late) {
+        violated[sla]++;
+        if(late > max_lateness[sla])
+            max_lateness[sla] = late;
+    }
+    unsigned bucket = late ? 64 - unsigned(__builtin_clzll(late)) : 0;
+    lateness[sla][bucket < LATENESS_BUCKETS ? bucket : LATENESS_BUCKETS - 1]++;
+    if(info.gpu_capable) {
+        gpu_completed[accelerated]++;
+        gpu_instructions[accelerated] += info.total_instructions;
+        gpu_runtime[accelerated] += now - info.arrival;
+    }
+}
+
+double RunStats::GPUThroughput(bool accelerated) const {
+    return gpu_runtime[accelerated] ? double(gpu_instructions[accelerated]) / double(gpu_runtime[accelerated]) : 0.0;
+}
+
+void RunStats::EstimateChecked(EstimateKind_t kind, Time_t from, Time_t estimate, Time_t actual) {
+    double error = double(actual > estimate ? actual - estimate : estimate - actual) / double(max<Time_t>(actual - from, 1));
+    estimates[kind]++;
+    estimates_accurate[kind] += error <= ESTIMATE_TOLERANCE ? 1 : 0;
+    estimate_error[kind] += error;
+}
+
+double RunStats::EstimatesAccurate(EstimateKind_t kind) const {
+    return estimates[kind] ? double(estimates_accurate[kind]) / double(estimates[kind]) * 100 : 0.0;
+}
+
+double RunStats::EstimateError(EstimateKind_t kind) const {
+    return estimates[kind] ? estimate_error[kind] / double(estimates[kind]) : 0.0;
+}
+
+double RunStats::ViolationRate(SLAType_t sla) const {
+    return completed[sla] ? double(violated[sla]) / double(completed[sla]) * 100 : 0.0;
+}
+
+Time_t RunStats::LatenessPercentile(SLAType_t sla, double fraction) const {
+    unsigned target = unsigned(double(completed[sla]) * fraction), seen = 0;
+    for(unsigned i = 0; i < LATENESS_BUCKETS; i++) {
+        seen += lateness[sla][i];
+        if(seen > target || seen == completed[sla])
+            return i ? min(Time_t(1) << i, max_lateness[sla]) : 0;
+    }
+    return max_lateness[sla];
+}
+
+uint64_t RunStats::Energy() {
+    unsigned total = Machine_GetTotal();
+    machine_energy.resize(total);
+    uint64_t sum = 0;
+    for(unsigned i = 0; i < total; i++) {
+        machine_energy[i] = Machine_GetEnergy(MachineId_t(i));
+        sum += machine_energy[i];
+    }
+    return sum;
+}
@@ -0,0 +1,64 @@
+//
+//  RunStats.hpp
+//  CloudSim
+//
+
+#ifndef RunStats_hpp
+#define RunStats_hpp
+
+#include <vector>
+
+#include "Interfaces.h"
+
+#define LATENESS_BUCKETS 48         // Bucket i holds lateness below 2^i us, bucket 0 the tasks on time
+#define ESTIMATE_TOLERANCE 0.10     // An estimate within this fraction of the time it looked ahead is accurate
+
+// The completion oracle estimates checked against what happened, see Cluster.hpp
+typedef enum {
+    ESTIMATE_FREE_CORE,             // EstimateCompletion() of a task added to a machine with a free core
+    ESTIMATE_CONTENDED,             // EstimateCompletion() of a task added to a machine with every core busy
+    ESTIMATE_DRAIN,                 // ProjectedFinish() after the last task added against when the machine went idle
+} EstimateKind_t;
+#define ESTIMATE_KINDS 3
+
+// Running SLA aggregate, updated once per completed task so that periodic queries are O(1).
+// Lateness is how far past its target_completion a task finished, 0 for tasks on time.
+// The GPU-capable tasks are also split by whether they finished on a machine with GPUs, and each group's
+// throughput is its instructions over the time its tasks spent from arrival to completion.
+class RunStats {
+public:
+    RunStats()                                              {}
+    void TaskCompleted(Time_t now, TaskId_t task_id, bool accelerated);
+
+    unsigned Completed(SLAType_t sla) const                 { return completed[sla]; }
+    unsigned Violated(SLAType_t sla) const                  { return violated[sla]; }
+    double ViolationRate(SLAType_t sla) const;              // Percentage like GetSLAReport()
+    Time_t LatenessPercentile(SLAType_t sla, double fraction) const;    // Upper bound of the bucket, in us
+    Time_t MaxLateness(SLAType_t sla) const                 { return max_lateness[sla]; }
+    unsigned GPUCapable(bool accelerated) const             { return gpu_completed[accelerated]; }
+    double GPUThroughput(bool accelerated) const;           // Instructions per us
+
+    // An estimate made at from of something that happened at actual
+    void EstimateChecked(EstimateKind_t kind, Time_t from, Time_t estimate, Time_t actual);
+    unsigned Estimates(EstimateKind_t kind) const           { return estimates[kind]; }
+    double EstimatesAccurate(EstimateKind_t kind) const;    // Percentage within ESTIMATE_TOLERANCE
+    double EstimateError(EstimateKind_t kind) const;        // Mean of |actual - estimate| / (actual - from)
+
+    // Reads the energy of every machine into one contiguous array and returns the total
+    uint64_t Energy();
+    const vector<uint64_t> & MachineEnergy() const          { return machine_energy; }
+private:
+    unsigned completed[NUM_SLAS] = {};
+    unsigned violated[NUM_SLAS] = {};
+    Time_t max_lateness[NUM_SLAS] = {};
+    unsigned lateness[NUM_SLAS][LATENESS_BUCKETS] = {};
+    unsigned gpu_completed[2] = {};                         // Indexed by accelerated
+    uint64_t gpu_instructions[2] = {};
+    Time_t gpu_runtime[2] = {};
+    unsigned estimates[ESTIMATE_KINDS] = {};
+    unsigned estimates_accurate[ESTIMATE_KINDS] = {};
+    double estimate_error[ESTIMATE_KINDS] = {};
+    vector<uint64_t> machine_energy;
+};
+
+#endif /* RunStats_hpp */
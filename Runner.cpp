@@ -0,0 +1,82 @@
+//
+//  Runner.cpp
+//  CloudSim
+//
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include <sys/wait.h>
+
+#include "Runner.hpp"
+
+string Runner_Quote(const string & text) {
+    string quoted = "'";
+    for(char c : text) {
+        if(c == '\'')
+            quoted += "'\\''";
+        else
+            quoted += c;
+    }
+    return quoted + "'";
+}
+
+string Runner_Simulate(const string & simulator, const string & input, const vector<string> & environment,
+                       string & output, double & wall_seconds) {
+    string command = "env ";
+    for(const string & variable : environment)
+        command += Runner_Quote(variable) + " ";
+    command += Runner_Quote(simulator) + " " + Runner_Quote(input) + " 2>&1";
+
+    auto start = chrono::steady_clock::now();
+    FILE * pipe = popen(command.c_str(), "r");
+    if(pipe == nullptr)
+        return "could not start " + simulator;
+    char buffer[4096];
+    size_t count;
+    output.clear();
+    while((count = fread(buffer, 1, sizeof(buffer), pipe)) > 0)
+        output.append(buffer, count);
+    int status = pclose(pipe);
+    wall_seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if(status != 0)
+        return WIFEXITED(status) ? "exit status " + to_string(WEXITSTATUS(status)) : "killed";
+    return "";
+}
+
+// Reads the number that follows key at the start of line, if the line starts with key
+static bool Field(const string & line, const string & key, double & value) {
+    if(line.compare(0, key.size(), key) != 0)
+        return false;
+    value = stod(line.substr(key.size()));
+    return true;
+}
+
+bool Runner_ParseReport(const string & output, RunnerReport_t & report) {
+    istringstream lines(output);
+    string line;
+    unsigned found = 0;
+    while(getline(lines, line)) {
+        found += Field(line, "SLA0: ", report.sla[0]);
+        found += Field(line, "SLA1: ", report.sla[1]);
+        found += Field(line, "SLA2: ", report.sla[2]);
+        found += Field(line, "Total Energy ", report.energy);
+        found += Field(line, "Simulation run finished in ", report.simulated);
+    }
+    return found == 5;
+}
+
+bool Runner_ReadValues(const string & filename, map<string, string> & values) {
+    ifstream file(filename);
+    if(!file)
+        return false;
+    string line;
+    while(getline(file, line)) {
+        size_t equal = line.find('=');
+        if(equal != string::npos)
+            values[line.substr(0, equal)] = line.substr(equal + 1);
+    }
+    return true;
+}
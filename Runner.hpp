@@ -0,0 +1,39 @@
+//
+//  Runner.hpp
+//  CloudSim
+//
+//  Helpers shared by the drivers (sweep, bench) that run the simulator as a child process.
+//
+
+#ifndef Runner_hpp
+#define Runner_hpp
+
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Quotes text for /bin/sh
+extern string           Runner_Quote(const string & text);
+
+// Runs simulator on input with the given NAME=value environment variables. The combined stdout and stderr
+// end up in output and the wall clock time in wall_seconds. Returns an empty string on success,
+// otherwise a description of what went wrong.
+extern string           Runner_Simulate(const string & simulator, const string & input, const vector<string> & environment,
+                                        string & output, double & wall_seconds);
+
+// The numbers in the report printed by SimulationComplete()
+typedef struct {
+    double sla[3];                          // SLA0..SLA2 violation percentage
+    double energy;                          // KW-Hour
+    double simulated;                       // Simulated seconds
+} RunnerReport_t;
+
+// Fills report from the simulator's output, false if any of its lines is missing
+extern bool             Runner_ParseReport(const string & output, RunnerReport_t & report);
+
+// Reads a file of name=value lines, such as the report written by Profile_Report()
+extern bool             Runner_ReadValues(const string & filename, map<string, string> & values);
+
+#endif /* Runner_hpp */
@@ -5,10 +5,16 @@
 //  Created by ELMOOTAZBELLAH ELNOZAHY on 10/20/24.
 //
 
+#include <algorithm>
+
+#include "Params.hpp"
+#include "Profile.hpp"
 #include "Scheduler.hpp"
+#include "SimLog.hpp"
 
-static bool migrating = false;
-static unsigned active_machines = 16;
+static Priority_t TaskPriority(TaskId_t task_id) {
+    return (task_id == 0 || task_id == 64)? HIGH_PRIORITY : MID_PRIORITY;
+}
 
 void Scheduler::Init() {
     // Find the parameters of the clusters
@@ -19,31 +25,74 @@ void Scheduler::Init() {
     //      Get the number of CPUs
     //      Get if there is a GPU or not
     // 
-    SimOutput("Scheduler::Init(): Total number of machines is " + to_string(Machine_GetTotal()), 3);
-    SimOutput("Scheduler::Init(): Initializing scheduler", 1);
+    SimLog<3>("Scheduler::Init(): Total number of machines is ", Machine_GetTotal());
+    SimLog<1>("Scheduler::Init(): Initializing scheduler");
+    active_machines = Param_Get("ACTIVE_MACHINES", 16u);
+    migrate_after = Param_Get("MIGRATE_AFTER", 10u);
+    batch_arrivals = Param_Get("BATCH_ARRIVALS", 0u) != 0;
+    batch_window = Time_t(Param_Get("BATCH_WINDOW", 0u));
+    max_migrations = Param_Get("MAX_MIGRATIONS", 1u);
+    migration_memory = Param_Get("MIGRATION_MEMORY", 0u);
+    queue_migrating = Param_Get("QUEUE_MIGRATING", 0u) != 0;
+    migrate_pressured = Param_Get("MIGRATE_PRESSURED", 0u) != 0;
+    wake_for_tasks = Param_Get("WAKE_FOR_TASKS", 0u) != 0;
+    boost_at_risk = Param_Get("BOOST_AT_RISK", 0u) != 0;
+    boost_quantum = Time_t(Param_Get("BOOST_QUANTUM", 10000000u));
+    check_oracle = Param_Get("CHECK_ORACLE", 0u) != 0;
+    skip_idle_checks = Time_t(Param_Get("SKIP_IDLE_CHECKS", 0u));
+    powered_machines = max(Param_Get("POWERED_MACHINES", 24u), active_machines);
+    if(active_machines == 0 || active_machines > Machine_GetTotal())
+        ThrowException("Scheduler::Init(): CLOUDSIM_ACTIVE_MACHINES is out of range: ", active_machines);
+    SimLog<3>("Scheduler::Init(): Using ", active_machines, " active machines, migrating after ", migrate_after, " checks");
+    cluster.Init();
+    double watermark = Param_Get("MEMORY_WATERMARK", 0.9);
+    if(watermark <= 0)
+        ThrowException("Scheduler::Init(): CLOUDSIM_MEMORY_WATERMARK must be positive");
+    cluster.SetWatermark(watermark, [this](MachineId_t machine_id, bool above) { MemoryPressure(machine_id, above); });
+    batch_memory.assign(cluster.Total(), 0);
+    if(check_oracle)
+        projected.assign(cluster.Total(), Estimate_t{ 0, 0, ESTIMATE_DRAIN });
+    waiting.resize(cluster.Total());
+    waiting_memory.assign(cluster.Total(), 0);
     for(unsigned i = 0; i < active_machines; i++)
-        vms.push_back(VM_Create(LINUX, X86));
+        vms.push_back(cluster.CreateVM(LINUX, cluster.Info(MachineId_t(i)).cpu));
+    // The VMs the policies create later grow it in StartMigration()
+    held.resize(*max_element(vms.begin(), vms.end()) + 1);
     for(unsigned i = 0; i < active_machines; i++) {
         machines.push_back(MachineId_t(i));
     }    
     for(unsigned i = 0; i < active_machines; i++) {
-        VM_Attach(vms[i], machines[i]);
+        cluster.Attach(vms[i], machines[i]);
     }
 
-    bool dynamic = false;
-    if(dynamic)
-        for(unsigned i = 0; i<4 ; i++)
-            for(unsigned j = 0; j < 8; j++)
-                Machine_SetCorePerformance(MachineId_t(0), j, P3);
+    governor.Init(cluster);
     // Turn off the ARM machines
-    for(unsigned i = 24; i < Machine_GetTotal(); i++)
-        Machine_SetState(MachineId_t(i), S5);
+    for(unsigned i = powered_machines; i < Machine_GetTotal(); i++)
+        cluster.SetState(MachineId_t(i), S5);
 
-    SimOutput("Scheduler::Init(): VM ids are " + to_string(vms[0]) + " ahd " + to_string(vms[1]), 3);
+    if(vms.size() > 1)
+        SimLog<3>("Scheduler::Init(): VM ids are ", vms[0], " ahd ", vms[1]);
+
+    policy = Policy_Create();
+    context.active_machines = active_machines;
+    context.spread_migrating = queue_migrating;
+    context.gpu_steering = Param_Get("GPU_STEERING", 0u) != 0;
+    WarmVMs(Param_Get("WARM_VMS", ""));
+    visit([&](auto & chosen) { chosen.Init(context); }, policy);
+    metrics.Start(cluster);
 }
 
 void Scheduler::MigrationComplete(Time_t time, VMId_t vm_id) {
     // Update your data structure. The VM now can receive new tasks
+    cluster.MigrationDone(vm_id);
+    changed = true;
+    if(vm_id < held.size() && !held[vm_id].empty()) {
+        vector<pair<TaskId_t, Priority_t>> tasks;
+        for(TaskId_t task_id : held[vm_id])
+            tasks.push_back({ task_id, TaskPriority(task_id) });
+        AddTasks(vm_id, tasks, time);
+        held[vm_id].clear();
+    }
 }
 
 void Scheduler::NewTask(Time_t now, TaskId_t task_id) {
@@ -64,13 +113,249 @@ void Scheduler::NewTask(Time_t now, TaskId_t task_id) {
     // Turn on a machine, migrate an existing VM from a loaded machine....
     //
     // Other possibilities as desired
-    Priority_t priority = (task_id == 0 || task_id == 64)? HIGH_PRIORITY : MID_PRIORITY;
-    if(migrating) {
-        VM_AddTask(vms[0], task_id, priority);
+    changed = true;
+    if(batch_arrivals) {
+        FlushArrivals(now);
+        if(arrivals.empty())
+            batch_since = now;
+        arrivals.push_back(task_id);
+        // A batch whose window has closed goes out before the callback returns, so with a window of 0 every
+        // task is placed at the time it arrived
+        if(now >= batch_since + batch_window) {
+            NewTasks(now, arrivals);
+            arrivals.clear();
+        }
+        return;
     }
-    else {
-        VM_AddTask(vms[task_id % active_machines], task_id, priority);
-    }// Skeleton code, you need to change it according to your algorithm
+    // Skeleton code, you need to change it according to your algorithm
+    unsigned memory = GetTaskMemory(task_id);
+    VMId_t vm = ChooseVM(task_id, memory);
+    if(queue_migrating && cluster.Migrating(vm)) {
+        held[vm].push_back(task_id);
+        return;
+    }
+    if(wake_for_tasks && cluster.Headroom(cluster.VMMachine(vm)) < memory && WaitForMachine(now, task_id, memory))
+        return;
+    AddTask(vm, task_id, now);
+}
+
+// Places the tasks in order like NewTask() does, then hands each VM its share in one Cluster::AddTasks() call
+void Scheduler::NewTasks(Time_t now, const vector<TaskId_t> & task_ids) {
+    placements.clear();
+    for(TaskId_t task_id : task_ids) {
+        unsigned memory = GetTaskMemory(task_id);
+        VMId_t vm = ChooseVM(task_id, memory);
+        if(queue_migrating && cluster.Migrating(vm)) {
+            held[vm].push_back(task_id);
+            continue;
+        }
+        MachineId_t machine = cluster.VMMachine(vm);
+        if(wake_for_tasks && cluster.Headroom(machine) < memory + batch_memory[machine] && WaitForMachine(now, task_id, memory))
+            continue;
+        batch_memory[machine] += memory;
+        placements.push_back({ vm, { task_id, TaskPriority(task_id) } });
+    }
+    stable_sort(placements.begin(), placements.end(),
+                [](const auto & a, const auto & b) { return a.first < b.first; });
+    vector<pair<TaskId_t, Priority_t>> batch;
+    for(unsigned i = 0; i < placements.size(); ) {
+        VMId_t vm = placements[i].first;
+        batch_memory[cluster.VMMachine(vm)] = 0;
+        batch.clear();
+        for(; i < placements.size() && placements[i].first == vm; i++)
+            batch.push_back(placements[i].second);
+        AddTasks(vm, batch, now);
+    }
+    SimLog<4>("Scheduler::NewTasks(): Placed ", task_ids.size(), " tasks at ", now);
+}
+
+// Forwards to the cluster. With check_oracle the estimates are taken as the tasks go in, each against the
+// machine as it was before the call, and checked in TaskComplete().
+void Scheduler::AddTask(VMId_t vm_id, TaskId_t task_id, Time_t now) {
+    MachineId_t machine = check_oracle ? cluster.VMMachine(vm_id) : NO_MACHINE;
+    bool estimate = machine != NO_MACHINE && cluster.SState(machine) == S0;
+    if(estimate) {
+        EstimateKind_t kind = cluster.ActiveTasks(machine) < cluster.Info(machine).num_cpus ? ESTIMATE_FREE_CORE : ESTIMATE_CONTENDED;
+        estimated[task_id] = Estimate_t{ now, cluster.EstimateTask(machine, task_id, now), kind };
+    }
+    cluster.AddTask(vm_id, task_id, TaskPriority(task_id));
+    if(estimate)
+        projected[machine] = Estimate_t{ now, cluster.ProjectedFinish(machine, now), ESTIMATE_DRAIN };
+}
+
+void Scheduler::AddTasks(VMId_t vm_id, const vector<pair<TaskId_t, Priority_t>> & tasks, Time_t now) {
+    MachineId_t machine = check_oracle ? cluster.VMMachine(vm_id) : NO_MACHINE;
+    bool estimate = machine != NO_MACHINE && cluster.SState(machine) == S0;
+    if(estimate) {
+        EstimateKind_t kind = cluster.ActiveTasks(machine) < cluster.Info(machine).num_cpus ? ESTIMATE_FREE_CORE : ESTIMATE_CONTENDED;
+        for(auto & task : tasks)
+            estimated[task.first] = Estimate_t{ now, cluster.EstimateTask(machine, task.first, now), kind };
+    }
+    cluster.AddTasks(vm_id, tasks);
+    if(estimate)
+        projected[machine] = Estimate_t{ now, cluster.ProjectedFinish(machine, now), ESTIMATE_DRAIN };
+}
+
+VMId_t Scheduler::ChooseVM(TaskId_t task_id, unsigned memory) {
+    return visit([&](auto & chosen) { return chosen.Place(context, task_id, memory); }, policy);
+}
+
+// Creates a VM of each type named in the comma separated list on every running machine it is compatible
+// with, so the first tasks of those types find one waiting instead of having it created for them
+void Scheduler::WarmVMs(const string & types) {
+    static const char * names[VM_TYPES] = { "LINUX", "LINUX_RT", "WIN", "AIX" };
+    size_t start = 0;
+    while(start < types.size()) {
+        size_t comma = min(types.find(',', start), types.size());
+        string name = types.substr(start, comma - start);
+        start = comma + 1;
+        auto it = find_if(begin(names), end(names), [&](const char * known) { return name == known; });
+        if(it == end(names))
+            ThrowException("Scheduler::WarmVMs(): Unknown VM type in CLOUDSIM_WARM_VMS: ", name);
+        VMType_t vm_type = VMType_t(it - begin(names));
+        unsigned ready = 0;
+        for(unsigned i = 0; i < cluster.Total(); i++) {
+            MachineId_t machine = MachineId_t(i);
+            if(cluster.SState(machine) == S0 && !cluster.InTransition(machine) && Cluster::Compatible(vm_type, cluster.Info(machine).cpu))
+                Policy_VMOn(context, machine, vm_type);
+        }
+        for(unsigned cpu = ARM; cpu < CPU_TYPES; cpu++)
+            ready += cluster.VMCount(vm_type, CPUType_t(cpu));
+        SimLog<3>("Scheduler::WarmVMs(): ", ready, " ", name, " VMs ready");
+    }
+}
+
+// SLAWarning() only comes from CompleteTask() once a task has finished late, so the tasks at risk are found
+// here instead. On a machine with more tasks than cores, a task that Cluster::EstimateRunning() has finishing
+// past its target is raised to HIGH_PRIORITY, which Machine::HandleTimer() picks up on its next tick.
+// The boost lasts boost_quantum, then the task goes back to its own priority and has to be found at risk
+// again, so the boosted tasks cannot hold the cores for good.
+void Scheduler::BoostAtRisk(Time_t now) {
+    while(!boosts.empty() && boosts.begin()->first <= now) {
+        TaskId_t task_id = boosts.begin()->second;
+        boosts.erase(boosts.begin());
+        SetTaskPriority(task_id, boosted[task_id].second);
+        boosted.erase(task_id);
+    }
+    for(unsigned i = 0; i < cluster.Total(); i++) {
+        MachineId_t machine = MachineId_t(i);
+        const MachineInfo_t & info = cluster.Info(machine);
+        if(cluster.ActiveTasks(machine) <= info.num_cpus || cluster.SState(machine) != S0)
+            continue;
+        for(VMId_t vm_id : cluster.MachineVMs(machine)) {
+            if(cluster.Migrating(vm_id))
+                continue;
+            for(TaskId_t task_id : cluster.VMActiveTasks(vm_id)) {
+                if(boosted.count(task_id))
+                    continue;
+                TaskInfo_t task = GetTaskInfo(task_id);
+                if(task.required_sla == SLA3 || task.priority == HIGH_PRIORITY || task.target_completion <= now)
+                    continue;
+                if(cluster.EstimateRunning(machine, task_id, now) <= task.target_completion)
+                    continue;
+                SetTaskPriority(task_id, HIGH_PRIORITY);
+                boosted[task_id] = { now + boost_quantum, task.priority };
+                boosts.insert({ now + boost_quantum, task_id });
+                SimLog<3>("Scheduler::BoostAtRisk(): Task ", task_id, " on machine ", machine, " is at risk, boosted until ", now + boost_quantum);
+            }
+        }
+    }
+}
+
+// Placement keeps to the headroom below the watermark, so crossing it means the cluster is running out of room
+void Scheduler::MemoryPressure(MachineId_t machine_id, bool above) {
+    if(above)
+        pressured.insert(machine_id);
+    else
+        pressured.erase(machine_id);
+    changed = true;
+    SimLog<2>("Scheduler::MemoryPressure(): Machine ", machine_id, above ? " is over" : " is back under", " its watermark with ",
+              cluster.MemoryUsed(machine_id), " of ", cluster.Info(machine_id).memory_size, " MB, ", pressured.size(), " machines over");
+}
+
+// The crossings are reported from inside the engine's task handling, so the VMs are moved from the periodic
+// check instead. Each machine over its watermark sends its largest VM that fits on another running machine
+// there, within the limits StartMigration() keeps on the migrations in flight.
+void Scheduler::RelievePressure() {
+    vector<MachineId_t> over(pressured.begin(), pressured.end());     // A migration out can take its machine off the set
+    for(MachineId_t machine : over) {
+        if(cluster.SState(machine) != S0 || cluster.InTransition(machine))
+            continue;
+        VMId_t largest = NO_VM;
+        MachineId_t target = NO_MACHINE;
+        for(VMId_t vm_id : cluster.MachineVMs(machine)) {
+            if(cluster.Migrating(vm_id) || (largest != NO_VM && cluster.VMMemory(vm_id) <= cluster.VMMemory(largest)))
+                continue;
+            MachineId_t found = cluster.FindMachine(cluster.Info(machine).cpu, cluster.VMMemory(vm_id), false);
+            if(found != NO_MACHINE && found != machine) {
+                largest = vm_id;
+                target = found;
+            }
+        }
+        if(largest != NO_VM && !StartMigration(largest, target) && cluster.Migrations() >= max_migrations)
+            return;
+    }
+}
+
+// Parks a task that fits on no running machine on one that is waking up, or wakes the sleeping machine that
+// comes up soonest. Only done if the task can still meet its deadline there, otherwise the caller places it.
+bool Scheduler::WaitForMachine(Time_t now, TaskId_t task_id, unsigned memory) {
+    TaskInfo_t task = GetTaskInfo(task_id);
+    MachineId_t machine = NO_MACHINE;
+    for(MachineId_t candidate : waking) {
+        const MachineInfo_t & info = cluster.Info(candidate);
+        if(info.cpu == task.required_cpu && info.memory_size >= cluster.MemoryUsed(candidate) + waiting_memory[candidate] + memory) {
+            machine = candidate;
+            break;
+        }
+    }
+    Time_t ready = machine != NO_MACHINE ? now + cluster.TimeToReady(machine, now) : 0;
+    for(unsigned s_state = S0i1; machine == NO_MACHINE && s_state < S_STATES; s_state++) {
+        machine = cluster.FindMachine(task.required_cpu, memory, false, MachineState_t(s_state));
+        if(machine != NO_MACHINE)
+            ready = now + Cluster::TransitionLatency(MachineState_t(s_state), S0);
+    }
+    if(machine == NO_MACHINE)
+        return false;
+    const MachineInfo_t & info = cluster.Info(machine);
+    if(task.required_sla != SLA3 && ready + task.remaining_instructions / info.performance[P0] > task.target_completion)
+        return false;
+
+    if(waiting[machine].empty()) {
+        if(cluster.RequestedState(machine) != S0)
+            cluster.SetState(machine, S0);
+        waking.push_back(machine);
+    }
+    waiting[machine].push_back(task_id);
+    waiting_memory[machine] += memory;
+    SimLog<3>("Scheduler::WaitForMachine(): Task ", task_id, " waits for machine ", machine, " until ", ready);
+    return true;
+}
+
+// Starts a migration if it stays within the limits on migrations in flight, which stand in for the link
+// the VMs are copied over. Tasks for the VM wait at the destination when queue_migrating is set.
+bool Scheduler::StartMigration(VMId_t vm_id, MachineId_t machine_id) {
+    if(cluster.Migrating(vm_id) || cluster.Migrations() >= max_migrations)
+        return false;
+    if(cluster.SState(machine_id) != S0 || cluster.InTransition(machine_id))
+        return false;
+    unsigned memory = cluster.VMMemory(vm_id);
+    if(migration_memory && cluster.Migrations() && cluster.MigratingMemory() + memory > migration_memory)
+        return false;
+    cluster.Migrate(vm_id, machine_id);
+    if(held.size() <= vm_id)
+        held.resize(vm_id + 1);
+    SimLog<3>("Scheduler::StartMigration(): VM ", vm_id, " with ", memory, " MB to machine ", machine_id, " until ", cluster.MigrationDoneAt(vm_id));
+    return true;
+}
+
+// The held arrivals go out once an arrival or a periodic check comes in past the batch window. The other
+// callbacks come from inside the engine's own event handling, where a flush from TaskComplete() aborts the simulator.
+void Scheduler::FlushArrivals(Time_t now) {
+    if(arrivals.empty() || now <= batch_since + batch_window)
+        return;
+    NewTasks(now, arrivals);
+    arrivals.clear();
 }
 
 void Scheduler::PeriodicCheck(Time_t now) {
@@ -78,6 +363,29 @@ void Scheduler::PeriodicCheck(Time_t now) {
     // SchedulerCheck is called periodically by the simulator to allow you to monitor, make decisions, adjustments, etc.
     // Unlike the other invocations of the scheduler, this one doesn't report any specific event
     // Recommendation: Take advantage of this function to do some monitoring and adjustments as necessary
+    checks++;
+    // The engine posts every tick whether or not anything moved. Skipping one only delays the time-driven
+    // work, the idle countdown, the governor window and the at-risk test, so it is bounded by skip_idle_checks
+    if(skip_idle_checks && !changed && arrivals.empty() && checks != migrate_after && !metrics.Due(now) &&
+       (boosts.empty() || boosts.begin()->first > now) && now < last_check + skip_idle_checks) {
+        skipped++;
+        return;
+    }
+    changed = false;
+    last_check = now;
+    FlushArrivals(now);
+    visit([&](auto & chosen) { chosen.Check(context, now); }, policy);
+    governor.Check(cluster, now);
+    if(metrics.Due(now))
+        metrics.Sample(now, cluster, stats, waiting);
+    if(boost_at_risk)
+        BoostAtRisk(now);
+    SimLog<4>("Scheduler::PeriodicCheck(): SLA violations ", stats.ViolationRate(SLA0), "% ", stats.ViolationRate(SLA1), "% ",
+              stats.ViolationRate(SLA2), "% after ", stats.Completed(SLA0) + stats.Completed(SLA1) + stats.Completed(SLA2), " tasks");
+    if(checks == migrate_after && vms.size() > 1)
+        StartMigration(vms[1], 9);
+    if(migrate_pressured)
+        RelievePressure();
 }
 
 void Scheduler::Shutdown(Time_t time) {
@@ -85,18 +393,82 @@ void Scheduler::Shutdown(Time_t time) {
     // Report about the total energy consumed
     // Report about the SLA compliance
     // Shutdown everything to be tidy :-)
+    // The simulator refuses to detach VMs from sleeping machines, those are left attached
     for(auto & vm: vms) {
-        VM_Shutdown(vm);
+        MachineId_t machine = cluster.VMMachine(vm);
+        if(machine != NO_MACHINE && cluster.SState(machine) == S0 && !cluster.InTransition(machine))
+            cluster.ShutdownVM(vm);
     }
-    SimOutput("SimulationComplete(): Finished!", 4);
-    SimOutput("SimulationComplete(): Time is " + to_string(time), 4);
+    if(SimLogLevel() >= 2) {
+        for(unsigned sla = SLA0; sla < NUM_SLAS; sla++) {
+            SLAType_t type = SLAType_t(sla);
+            if(stats.Completed(type) == 0)
+                continue;
+            SimLog<2>("Scheduler::Shutdown(): SLA", sla, " ", stats.Violated(type), " of ", stats.Completed(type), " tasks late, lateness p50 ",
+                      stats.LatenessPercentile(type, 0.50), " p99 ", stats.LatenessPercentile(type, 0.99), " max ", stats.MaxLateness(type), " us");
+        }
+        if(stats.GPUCapable(true) + stats.GPUCapable(false))
+            SimLog<2>("Scheduler::Shutdown(): GPU-capable tasks ", stats.GPUCapable(true), " on GPUs at ", stats.GPUThroughput(true),
+                      " instructions/us, ", stats.GPUCapable(false), " on CPUs at ", stats.GPUThroughput(false), " instructions/us");
+        uint64_t energy = stats.Energy();
+        for(unsigned i = 0; i < stats.MachineEnergy().size(); i++)
+            SimLog<3>("Scheduler::Shutdown(): Machine ", i, " used ", stats.MachineEnergy()[i], " of ", energy);
+    }
+    if(skip_idle_checks)
+        SimLog<1>("Scheduler::Shutdown(): Skipped ", skipped, " of ", checks, " periodic checks");
+    static const char * estimate_names[ESTIMATE_KINDS] = { "free core", "contended", "drain" };
+    for(unsigned kind = 0; check_oracle && kind < ESTIMATE_KINDS; kind++)
+        SimLog<1>("Scheduler::Shutdown(): Oracle ", estimate_names[kind], " estimates ", stats.Estimates(EstimateKind_t(kind)), ", ",
+                  stats.EstimatesAccurate(EstimateKind_t(kind)), "% within ", ESTIMATE_TOLERANCE * 100, "%, mean error ",
+                  stats.EstimateError(EstimateKind_t(kind)) * 100, "%");
+    metrics.Stop();
+    SimLog<4>("SimulationComplete(): Finished!");
+    SimLog<4>("SimulationComplete(): Time is ", time);
 }
 
 void Scheduler::TaskComplete(Time_t now, TaskId_t task_id) {
     // Do any bookkeeping necessary for the data structures
     // Decide if a machine is to be turned off, slowed down, or VMs to be migrated according to your policy
     // This is an opportunity to make any adjustments to optimize performance/energy
-    SimOutput("Scheduler::TaskComplete(): Task " + to_string(task_id) + " is complete at " + to_string(now), 4);
+    VMId_t vm_id = cluster.TaskVM(task_id);
+    bool accelerated = vm_id != NO_VM && cluster.VMMachine(vm_id) != NO_MACHINE && cluster.Accelerated(cluster.VMMachine(vm_id), task_id);
+    MachineId_t machine = vm_id != NO_VM ? cluster.VMMachine(vm_id) : NO_MACHINE;
+    cluster.TaskDone(task_id);
+    changed = true;
+    stats.TaskCompleted(now, task_id, accelerated);
+    auto estimate = estimated.find(task_id);
+    if(estimate != estimated.end()) {
+        stats.EstimateChecked(estimate->second.kind, estimate->second.made, estimate->second.completion, now);
+        estimated.erase(estimate);
+    }
+    if(check_oracle && machine != NO_MACHINE && cluster.ActiveTasks(machine) == 0 && projected[machine].completion) {
+        stats.EstimateChecked(ESTIMATE_DRAIN, projected[machine].made, projected[machine].completion, now);
+        projected[machine].completion = 0;
+    }
+    auto boost = boosted.find(task_id);
+    if(boost != boosted.end()) {
+        boosts.erase({ boost->second.first, task_id });
+        boosted.erase(boost);
+    }
+    SimLog<4>("Scheduler::TaskComplete(): Task ", task_id, " is complete at ", now);
+}
+
+void Scheduler::StateChange(Time_t now, MachineId_t machine_id) {
+    cluster.StateChangeDone(machine_id);
+    changed = true;
+    if(cluster.SState(machine_id) != S0 || waiting[machine_id].empty())
+        return;
+
+    // The machine woke up for the tasks waiting on it, each goes to a VM of its type
+    vector<pair<TaskId_t, Priority_t>> tasks[VM_TYPES];
+    for(TaskId_t task_id : waiting[machine_id])
+        tasks[RequiredVMType(task_id)].push_back({ task_id, TaskPriority(task_id) });
+    for(unsigned vm_type = LINUX; vm_type < VM_TYPES; vm_type++)
+        if(!tasks[vm_type].empty())
+            AddTasks(Policy_VMOn(context, machine_id, VMType_t(vm_type)), tasks[vm_type], now);
+    waiting[machine_id].clear();
+    waiting_memory[machine_id] = 0;
+    waking.erase(find(waking.begin(), waking.end(), machine_id));
 }
 
 // Public interface below
@@ -104,62 +476,66 @@ void Scheduler::TaskComplete(Time_t now, TaskId_t task_id) {
 static Scheduler Scheduler;
 
 void InitScheduler() {
-    SimOutput("InitScheduler(): Initializing scheduler", 4);
+    SimLog<4>("InitScheduler(): Initializing scheduler");
     Scheduler.Init();
+    Profile_Start();
 }
 
 void HandleNewTask(Time_t time, TaskId_t task_id) {
-    SimOutput("HandleNewTask(): Received new task " + to_string(task_id) + " at time " + to_string(time), 4);
+    ProfileScope profile(PROFILE_NEW_TASK);
+    SimLog<4>("HandleNewTask(): Received new task ", task_id, " at time ", time);
     Scheduler.NewTask(time, task_id);
 }
 
 void HandleTaskCompletion(Time_t time, TaskId_t task_id) {
-    SimOutput("HandleTaskCompletion(): Task " + to_string(task_id) + " completed at time " + to_string(time), 4);
+    ProfileScope profile(PROFILE_TASK_COMPLETION);
+    SimLog<4>("HandleTaskCompletion(): Task ", task_id, " completed at time ", time);
     Scheduler.TaskComplete(time, task_id);
 }
 
 void MemoryWarning(Time_t time, MachineId_t machine_id) {
+    ProfileScope profile(PROFILE_MEMORY_WARNING);
     // The simulator is alerting you that machine identified by machine_id is overcommitted
-    SimOutput("MemoryWarning(): Overflow at " + to_string(machine_id) + " was detected at time " + to_string(time), 0);
+    SimLog<0>("MemoryWarning(): Overflow at ", machine_id, " was detected at time ", time);
 }
 
 void MigrationDone(Time_t time, VMId_t vm_id) {
+    ProfileScope profile(PROFILE_MIGRATION_DONE);
     // The function is called on to alert you that migration is complete
-    SimOutput("MigrationDone(): Migration of VM " + to_string(vm_id) + " was completed at time " + to_string(time), 4);
+    SimLog<4>("MigrationDone(): Migration of VM ", vm_id, " was completed at time ", time);
     Scheduler.MigrationComplete(time, vm_id);
-    migrating = false;
 }
 
 void SchedulerCheck(Time_t time) {
+    ProfileScope profile(PROFILE_SCHEDULER_CHECK);
     // This function is called periodically by the simulator, no specific event
-    SimOutput("SchedulerCheck(): SchedulerCheck() called at " + to_string(time), 4);
+    SimLog<4>("SchedulerCheck(): SchedulerCheck() called at ", time);
     Scheduler.PeriodicCheck(time);
-    static unsigned counts = 0;
-    counts++;
-    if(counts == 10) {
-        migrating = true;
-        VM_Migrate(1, 9);
-    }
 }
 
 void SimulationComplete(Time_t time) {
     // This function is called before the simulation terminates Add whatever you feel like.
-    cout << "SLA violation report" << endl;
-    cout << "SLA0: " << GetSLAReport(SLA0) << "%" << endl;
-    cout << "SLA1: " << GetSLAReport(SLA1) << "%" << endl;
-    cout << "SLA2: " << GetSLAReport(SLA2) << "%" << endl;     // SLA3 do not have SLA violation issues
-    cout << "Total Energy " << Machine_GetClusterEnergy() << "KW-Hour" << endl;
-    cout << "Simulation run finished in " << double(time)/1000000 << " seconds" << endl;
-    SimOutput("SimulationComplete(): Simulation finished at time " + to_string(time), 4);
+    cout << "SLA violation report" << '\n';
+    cout << "SLA0: " << GetSLAReport(SLA0) << "%" << '\n';
+    cout << "SLA1: " << GetSLAReport(SLA1) << "%" << '\n';
+    cout << "SLA2: " << GetSLAReport(SLA2) << "%" << '\n';     // SLA3 do not have SLA violation issues
+    cout << "Total Energy " << Machine_GetClusterEnergy() << "KW-Hour" << '\n';
+    cout << "Simulation run finished in " << double(time)/1000000 << " seconds" << '\n';
+    SimLog<4>("SimulationComplete(): Simulation finished at time ", time);
     
     Scheduler.Shutdown(time);
+    Profile_Report(time);
+    cout.flush();
 }
 
 void SLAWarning(Time_t time, TaskId_t task_id) {
-    
+    ProfileScope profile(PROFILE_SLA_WARNING);
+    // Sent as the task completes past its target, too late to act on; see Scheduler::BoostAtRisk()
 }
 
 void StateChangeComplete(Time_t time, MachineId_t machine_id) {
     // Called in response to an earlier request to change the state of a machine
+    ProfileScope profile(PROFILE_STATE_CHANGE);
+    Scheduler.StateChange(time, machine_id);
 }
 
@@ -8,22 +8,89 @@
 #ifndef Scheduler_hpp
 #define Scheduler_hpp
 
+#include <set>
+#include <unordered_map>
 #include <vector>
 
+#include "Cluster.hpp"
+#include "Governor.hpp"
 #include "Interfaces.h"
+#include "Metrics.hpp"
+#include "Policy.hpp"
+#include "RunStats.hpp"
+
+// A completion oracle estimate waiting for the event it predicts
+typedef struct {
+    Time_t made;
+    Time_t completion;                          // 0 when there is none
+    EstimateKind_t kind;
+} Estimate_t;
 
 class Scheduler {
 public:
-    Scheduler()                 {}
+    Scheduler() : context{ cluster, vms, 16, batch_memory, false, false } {}
     void Init();
     void MigrationComplete(Time_t time, VMId_t vm_id);
     void NewTask(Time_t now, TaskId_t task_id);
+    void NewTasks(Time_t now, const vector<TaskId_t> & task_ids);
     void PeriodicCheck(Time_t now);
     void Shutdown(Time_t now);
+    void StateChange(Time_t now, MachineId_t machine_id);
     void TaskComplete(Time_t now, TaskId_t task_id);
 private:
+    void AddTask(VMId_t vm_id, TaskId_t task_id, Time_t now);
+    void AddTasks(VMId_t vm_id, const vector<pair<TaskId_t, Priority_t>> & tasks, Time_t now);
+    void BoostAtRisk(Time_t now);
+    VMId_t ChooseVM(TaskId_t task_id, unsigned memory);
+    void FlushArrivals(Time_t now);
+    void MemoryPressure(MachineId_t machine_id, bool above);
+    void RelievePressure();
+    bool StartMigration(VMId_t vm_id, MachineId_t machine_id);
+    bool WaitForMachine(Time_t now, TaskId_t task_id, unsigned memory);
+    void WarmVMs(const string & types);
+
+    Cluster cluster;
+    Governor governor;
+    Metrics metrics;                            // See Metrics.hpp
+    Policy_t policy;                            // See Policy.hpp
+    PolicyContext_t context;
+    RunStats stats;
+
+    // Policy parameters, see Params.hpp
+    unsigned active_machines = 16;              // Machines that get a VM at Init()
+    unsigned migrate_after = 10;                // The sample migration fires on this periodic check, 0 never
+    unsigned max_migrations = 1;                // Migrations allowed in flight at once
+    unsigned migration_memory = 0;              // Memory allowed in flight across migrations, 0 for no limit
+    bool queue_migrating = false;               // Tasks for a migrating VM wait for it at the destination
+    bool migrate_pressured = false;             // Machines over the memory watermark move a VM off at each periodic check
+    unsigned powered_machines = 24;             // Machines from this one on are turned off at Init()
+    bool batch_arrivals = false;                // Arrivals are held and placed together through NewTasks()
+    Time_t batch_window = 0;                    // Arrivals this close to the first held one join its batch, in us, 0 for the same time
+    bool wake_for_tasks = false;                // Tasks that fit on no running machine wait for a sleeping one to wake up
+    bool boost_at_risk = false;                 // Raise tasks that would miss their target to HIGH_PRIORITY
+    Time_t boost_quantum = 10000000;            // How long a boost lasts before the task goes back to its priority, in us
+    bool check_oracle = false;                  // Check the completion oracle against the completions, reported at Shutdown()
+    Time_t skip_idle_checks = 0;                // Periodic checks with nothing new to act on are skipped for up to this long, in us, 0 never
+
+    unsigned checks = 0;                        // Periodic checks seen so far
+    unsigned skipped = 0;                       // Of those, skipped with skip_idle_checks
+    bool changed = true;                        // An event came in since the last periodic check that ran
+    Time_t last_check = 0;                      // When that check ran
+    set<MachineId_t> pressured;                 // Machines over the memory watermark
     vector<VMId_t> vms;
+    vector<TaskId_t> arrivals;                  // Held for the next batch
+    Time_t batch_since = 0;                     // Arrival time of the first held task
+    vector<unsigned> batch_memory;              // Memory promised on each machine by the batch being placed
+    vector<pair<VMId_t, pair<TaskId_t, Priority_t>>> placements;
+    vector<MachineId_t> waking;                 // Machines woken up for the tasks waiting on them
+    vector<vector<TaskId_t>> waiting;           // Indexed by MachineId_t
+    vector<unsigned> waiting_memory;
+    vector<vector<TaskId_t>> held;              // Tasks waiting for their VM to finish migrating, by VMId_t
     vector<MachineId_t> machines;
+    set<pair<Time_t, TaskId_t>> boosts;         // Boosted tasks by when their boost expires
+    unordered_map<TaskId_t, pair<Time_t, Priority_t>> boosted;    // Expiry and priority to restore
+    unordered_map<TaskId_t, Estimate_t> estimated;  // With check_oracle, the completion estimate of each task in flight
+    vector<Estimate_t> projected;               // With check_oracle, the last ProjectedFinish() of each machine
 };
 
 
@@ -0,0 +1,41 @@
+//
+//  SimLog.cpp
+//  CloudSim
+//
+
+#include <streambuf>
+
+#include "SimLog.hpp"
+
+// Counts the characters written through it without storing them
+class ProbeBuffer : public streambuf {
+public:
+    ProbeBuffer()               { written = 0; }
+    unsigned Written()          { return written; }
+protected:
+    int overflow(int c) override { written++; return c; }
+private:
+    unsigned written;
+};
+
+// SimOutput() keeps the -v level to itself. Send an empty message at each level into a probe and
+// take the highest level that made it through.
+static unsigned ProbeVerboseLevel() {
+    ProbeBuffer probe;
+    streambuf * saved = cout.rdbuf(&probe);
+    unsigned level = 0;
+    for(unsigned i = 0; i <= SIM_VERBOSE_CEILING; i++) {
+        unsigned before = probe.Written();
+        SimOutput("", i);
+        if(probe.Written() == before)
+            break;
+        level = i;
+    }
+    cout.rdbuf(saved);
+    return level;
+}
+
+unsigned SimLogLevel() {
+    static const unsigned level = ProbeVerboseLevel();
+    return level;
+}
@@ -0,0 +1,35 @@
+//
+//  SimLog.hpp
+//  CloudSim
+//
+
+#ifndef SimLog_hpp
+#define SimLog_hpp
+
+#include <iostream>
+
+#include "Interfaces.h"
+
+// Messages above this level are removed at compile time, e.g. build with -DSIM_VERBOSE_CEILING=0
+// to strip all of the scheduler's tracing from the event callbacks.
+#ifndef SIM_VERBOSE_CEILING
+#define SIM_VERBOSE_CEILING 4
+#endif
+
+// The verbose level given to the simulator with -v. It is discovered once from SimOutput() itself.
+extern unsigned SimLogLevel();
+
+// Lazily formatted replacement for SimOutput(). The arguments are only streamed once the message
+// passes both the compile-time ceiling and the runtime level, so a filtered call costs a compare.
+// Lines go to the same stream as SimOutput() but are not flushed one by one.
+// Usage: SimLog<4>("HandleNewTask(): Received new task ", task_id, " at time ", time);
+template <unsigned level, typename... Args>
+inline void SimLog(const Args &... args) {
+    if constexpr(level <= SIM_VERBOSE_CEILING) {
+        if(level > SimLogLevel())
+            return;
+        (cout << ... << args) << '\n';
+    }
+}
+
+#endif /* SimLog_hpp */
@@ -43,6 +43,7 @@ typedef enum {
     RISCV,
     X86
 } CPUType_t;
+#define CPU_TYPES 4
 
 typedef enum {
     S0,         // Machine is up. CPU's are at state C0 if running a task or C1
@@ -84,6 +85,7 @@ typedef enum {
     WIN,
     AIX
 } VMType_t;
+#define VM_TYPES 4
 #define VM_MEMORY_OVERHEAD  8 
 
 typedef struct {
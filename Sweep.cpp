@@ -0,0 +1,130 @@
+//
+//  Sweep.cpp
+//  CloudSim
+//
+//  Runs one simulation per configuration across a pool of threads and prints a summary table.
+//  The simulator keeps its state in globals, so every configuration runs in its own process;
+//  the parameters reach the scheduler through the CLOUDSIM_ environment variables (see Params.hpp).
+//
+//  Usage: sweep [-j threads] [-s simulator] sweep_file input_file
+//  Each line of sweep_file is one configuration made of name=value pairs, e.g.
+//      active_machines=8 migrate_after=20
+//  Blank lines and lines starting with # are skipped.
+//
+
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Runner.hpp"
+
+typedef struct {
+    string settings;                        // The line from the sweep file
+    vector<string> environment;             // CLOUDSIM_NAME=value for each setting
+    RunnerReport_t report;
+    double wall;                            // Wall clock seconds
+    bool ok;
+    string error;
+} Run_t;
+
+static bool ReadSweep(const string & filename, vector<Run_t> & runs) {
+    ifstream file(filename);
+    if(!file)
+        return false;
+    string line;
+    while(getline(file, line)) {
+        istringstream words(line);
+        string word;
+        Run_t run = {};
+        while(words >> word) {
+            if(word[0] == '#')
+                break;
+            size_t equal = word.find('=');
+            if(equal == string::npos || equal == 0) {
+                cerr << "sweep: Expected name=value but found " << word << endl;
+                return false;
+            }
+            string name = word.substr(0, equal);
+            for(char & c : name)
+                c = char(toupper(c));
+            run.environment.push_back("CLOUDSIM_" + name + "=" + word.substr(equal + 1));
+            run.settings += (run.settings.empty() ? "" : " ") + word;
+        }
+        if(!run.settings.empty())
+            runs.push_back(run);
+    }
+    return true;
+}
+
+static void Simulate(const string & simulator, const string & input, Run_t & run) {
+    string output;
+    run.error = Runner_Simulate(simulator, input, run.environment, output, run.wall);
+    if(run.error.empty()) {
+        run.ok = Runner_ParseReport(output, run.report);
+        if(!run.ok)
+            run.error = "incomplete report";
+    }
+}
+
+static void PrintTable(const vector<Run_t> & runs) {
+    size_t width = 13;
+    for(const Run_t & run : runs)
+        width = max(width, run.settings.size());
+    cout << left << setw(int(width)) << "Configuration" << right
+         << setw(10) << "SLA0 %" << setw(10) << "SLA1 %" << setw(10) << "SLA2 %"
+         << setw(14) << "Energy KWh" << setw(12) << "Sim s" << setw(10) << "Wall s" << endl;
+    cout << fixed;
+    for(const Run_t & run : runs) {
+        cout << left << setw(int(width)) << run.settings << right;
+        if(!run.ok) {
+            cout << "  failed: " << run.error << endl;
+            continue;
+        }
+        cout << setprecision(4) << setw(10) << run.report.sla[0] << setw(10) << run.report.sla[1] << setw(10) << run.report.sla[2]
+             << setprecision(6) << setw(14) << run.report.energy
+             << setprecision(2) << setw(12) << run.report.simulated << setprecision(3) << setw(10) << run.wall << endl;
+    }
+}
+
+int main(int argc, char * argv[]) {
+    unsigned threads = thread::hardware_concurrency();
+    string simulator = "./simulator";
+    int arg = 1;
+    for(; arg < argc - 2; arg++) {
+        string option = argv[arg];
+        if(option == "-j" && arg + 1 < argc - 2)
+            threads = unsigned(stoul(argv[++arg]));
+        else if(option == "-s" && arg + 1 < argc - 2)
+            simulator = argv[++arg];
+        else
+            break;
+    }
+    if(argc - arg != 2) {
+        cerr << "Usage: " << argv[0] << " [-j threads] [-s simulator] sweep_file input_file" << endl;
+        return 1;
+    }
+    vector<Run_t> runs;
+    if(!ReadSweep(argv[arg], runs)) {
+        cerr << "sweep: Could not read sweep file " << argv[arg] << endl;
+        return 1;
+    }
+    string input = argv[arg + 1];
+
+    atomic<size_t> next(0);
+    vector<thread> pool;
+    for(unsigned i = 0; i < max(1u, threads); i++)
+        pool.emplace_back([&]() {
+            for(size_t job = next++; job < runs.size(); job = next++)
+                Simulate(simulator, input, runs[job]);
+        });
+    for(thread & worker : pool)
+        worker.join();
+
+    PrintTable(runs);
+    return 0;
+}
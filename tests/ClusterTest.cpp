@@ -0,0 +1,157 @@
+//
+//  ClusterTest.cpp
+//  CloudSim
+//
+//  Drives the Cluster mirror through VMs, tasks, watermarks, state changes and a migration on the fake
+//  simulator, checking the lookups and the placement index after each step.
+//
+
+#include "Cluster.hpp"
+#include "FakeSimulator.hpp"
+#include "Test.hpp"
+
+int main() {
+    MachineId_t x86 = Fake_AddMachine(X86, 4, 1000, false);
+    MachineId_t gpu = Fake_AddMachine(X86, 8, 2000, true);
+    MachineId_t arm = Fake_AddMachine(ARM, 4, 1000, false);
+    MachineId_t small = Fake_AddMachine(X86, 4, 500, false);
+    TaskId_t web = Fake_AddTask(X86, LINUX, 100, 1000000, 0, 10000000);
+    TaskId_t stream = Fake_AddTask(X86, LINUX, 200, 4000000, 0, 10000000);
+    TaskId_t ai = Fake_AddTask(X86, LINUX, 50, 20000000, 0, 10000000, SLA1, true);
+
+    Cluster cluster;
+    cluster.Init();
+    CHECK(cluster.Total() == 4);
+    CHECK(cluster.Info(gpu).memory_size == 2000);
+    CHECK(cluster.MemoryFree(small) == 500);
+    CHECK(cluster.Headroom(small) == 500);
+    CHECK(cluster.TaskVM(web) == NO_VM);
+
+    // Least headroom that fits, machines without GPUs first
+    CHECK(cluster.FindMachine(X86, 400, false) == small);
+    CHECK(cluster.FindMachine(X86, 600, false) == x86);
+    CHECK(cluster.FindMachine(X86, 1500, false) == gpu);
+    CHECK(cluster.FindMachine(X86, 600, true) == gpu);
+    CHECK(cluster.FindMachine(X86, 3000, false) == NO_MACHINE);
+    CHECK(cluster.FindMachine(POWER, 1, false) == NO_MACHINE);
+    CHECK(cluster.MostFree(X86, false) == x86);
+    CHECK(cluster.MostFree(X86, true) == gpu);
+    CHECK(cluster.MostFree(ARM, false) == arm);
+
+    VMId_t vm = cluster.CreateVM(LINUX, X86);
+    cluster.Attach(vm, small);
+    CHECK(cluster.VMMachine(vm) == small);
+    CHECK(cluster.MemoryUsed(small) == VM_MEMORY_OVERHEAD);
+    CHECK(cluster.MachineVM(small, LINUX) == vm);
+    CHECK(cluster.MachineVM(small, WIN) == NO_VM);
+    CHECK(cluster.MachineVMs(small).size() == 1);
+    CHECK(cluster.VMCount(LINUX, X86) == 1);
+    CHECK(cluster.Info(small).active_vms == 1);
+
+    fake_now = 1000;
+    cluster.AddTask(vm, web, MID_PRIORITY);
+    CHECK(cluster.TaskVM(web) == vm);
+    CHECK(cluster.ActiveTasks(small) == 1);
+    CHECK(cluster.MemoryUsed(small) == VM_MEMORY_OVERHEAD + 100);
+    CHECK(cluster.VMMemory(vm) == VM_MEMORY_OVERHEAD + 100);
+    CHECK(cluster.VMActiveTasks(vm).size() == 1);
+    // A free core runs the task alone at 1000 MIPS
+    CHECK(cluster.Backlog(small, fake_now) == 1000000);
+    CHECK(cluster.EstimateCompletion(small, 1000000, fake_now) == fake_now + 1000);
+    CHECK(cluster.ProjectedFinish(small, fake_now) == fake_now + 1000);
+    CHECK(cluster.FindMachine(X86, 400, false) == x86);
+    CHECK(cluster.FindMachine(X86, 300, false) == small);
+
+    // Memory promised to a machine takes it out of the search
+    vector<unsigned> promised(cluster.Total(), 0);
+    promised[small] = 100;
+    CHECK(cluster.FindMachine(X86, 300, false, S0, &promised) == x86);
+    promised[x86] = 800;
+    CHECK(cluster.FindMachine(X86, 300, false, S0, &promised) == gpu);
+
+    // The watermark lowers the headroom and reports the crossings both ways
+    vector<pair<MachineId_t, bool>> crossings;
+    cluster.SetWatermark(0.5, [&](MachineId_t machine_id, bool above) { crossings.push_back({ machine_id, above }); });
+    CHECK(cluster.Headroom(small) == 250 - VM_MEMORY_OVERHEAD - 100);
+    CHECK(cluster.FindMachine(X86, 200, false) == x86);
+    cluster.AddTasks(vm, { { stream, LOW_PRIORITY } });
+    // The machine drains when its longest task does, not when the backlog would on the busy cores
+    CHECK(cluster.ProjectedFinish(small, fake_now) == fake_now + 4000);
+    CHECK(cluster.Headroom(small) == 0);
+    CHECK(crossings.size() == 1 && crossings[0].first == small && crossings[0].second);
+    CHECK(cluster.ActiveTasks(small) == 2);
+    cluster.TaskDone(stream);
+    CHECK(crossings.size() == 2 && crossings[1].first == small && !crossings[1].second);
+    cluster.TaskDone(web);
+    CHECK(cluster.TaskVM(web) == NO_VM);
+    CHECK(cluster.ActiveTasks(small) == 0);
+    CHECK(cluster.MemoryUsed(small) == VM_MEMORY_OVERHEAD);
+    cluster.TaskDone(web);
+    CHECK(cluster.MemoryUsed(small) == VM_MEMORY_OVERHEAD);
+
+    // A machine in transition is out of the index until the change completes
+    fake_now = 2000;
+    cluster.SetState(x86, S3);
+    CHECK(cluster.InTransition(x86));
+    CHECK(cluster.RequestedState(x86) == S3);
+    CHECK(cluster.TimeToReady(x86, fake_now) == Cluster::TransitionLatency(S0, S3));
+    CHECK(cluster.FindMachine(X86, 400, false) == gpu);
+    CHECK(cluster.FindMachine(X86, 400, false, S3) == NO_MACHINE);
+    cluster.StateChangeDone(x86);
+    CHECK(!cluster.InTransition(x86));
+    CHECK(cluster.SState(x86) == S3);
+    CHECK(cluster.FindMachine(X86, 400, false, S3) == x86);
+    CHECK(cluster.MostFree(X86, false) == small);
+    cluster.SetState(arm, S0);
+    CHECK(!cluster.InTransition(arm));
+    CHECK(cluster.MostFree(ARM, false) == arm);
+
+    // The migrating VM belongs to no machine, its task memory stays on the source until it lands
+    cluster.AddTask(vm, ai, MID_PRIORITY);
+    CHECK(cluster.GPUTasks(small) == 0);
+    cluster.Migrate(vm, gpu);
+    CHECK(cluster.Migrating(vm));
+    CHECK(cluster.MigrationTarget(vm) == gpu);
+    CHECK(cluster.Incoming(gpu) == 1 && cluster.Incoming(small) == 0);
+    CHECK(cluster.MigrationDoneAt(vm) == fake_now + MIGRATION_TIME);
+    CHECK(cluster.Migrations() == 1);
+    CHECK(cluster.MigratingMemory() == VM_MEMORY_OVERHEAD + 50);
+    CHECK(cluster.MachineVM(small, LINUX) == NO_VM);
+    CHECK(cluster.MachineVMs(small).empty());
+    CHECK(cluster.ActiveTasks(small) == 0);
+    CHECK(cluster.MemoryUsed(small) == 50);
+    CHECK(cluster.VMCount(LINUX, X86) == 0);
+    fake_now += MIGRATION_TIME;
+    cluster.MigrationDone(vm);
+    CHECK(!cluster.Migrating(vm));
+    CHECK(cluster.Incoming(gpu) == 0);
+    CHECK(cluster.VMMachine(vm) == gpu);
+    CHECK(cluster.MachineVM(gpu, LINUX) == vm);
+    CHECK(cluster.ActiveTasks(gpu) == 1);
+    CHECK(cluster.GPUTasks(gpu) == 1);
+    CHECK(cluster.Accelerated(gpu, ai));
+    CHECK(cluster.MemoryUsed(gpu) == VM_MEMORY_OVERHEAD + 50);
+    CHECK(cluster.Migrations() == 0 && cluster.MigratingMemory() == 0);
+    CHECK(cluster.VMCount(LINUX, X86) == 1);
+    // GPU-capable work counts 1/GPU_SPEEDUP of its instructions
+    CHECK(cluster.Backlog(gpu, fake_now) == 20000000 / GPU_SPEEDUP);
+    cluster.TaskDone(ai);
+    CHECK(cluster.GPUTasks(gpu) == 0);
+
+    // The first VM of a type stands for the machine until it goes, then the next one does
+    VMId_t first = cluster.CreateVM(LINUX, ARM), second = cluster.CreateVM(LINUX, ARM);
+    cluster.Attach(first, arm);
+    cluster.Attach(second, arm);
+    CHECK(cluster.MachineVM(arm, LINUX) == first);
+    CHECK(cluster.VMCount(LINUX, ARM) == 2);
+    cluster.ShutdownVM(first);
+    CHECK(cluster.VMMachine(first) == NO_MACHINE);
+    CHECK(cluster.MachineVM(arm, LINUX) == second);
+    CHECK(cluster.VMCount(LINUX, ARM) == 1);
+    CHECK(cluster.MemoryUsed(arm) == VM_MEMORY_OVERHEAD);
+
+    CHECK(Cluster::Compatible(AIX, POWER) && !Cluster::Compatible(AIX, X86));
+    CHECK(!Cluster::Compatible(WIN, POWER) && !Cluster::Compatible(WIN, RISCV) && Cluster::Compatible(WIN, ARM));
+    CHECK(Cluster::Compatible(LINUX_RT, RISCV));
+    return Test_Result("ClusterTest");
+}
@@ -0,0 +1,134 @@
+//
+//  FakeSimulator.cpp
+//  CloudSim
+//
+//  Stands in for the prebuilt simulator objects so the scheduler-side modules can be tested on their own.
+//
+
+#include <algorithm>
+
+#include "FakeSimulator.hpp"
+#include "Test.hpp"
+
+unsigned test_failures = 0;
+
+vector<MachineInfo_t> fake_machines;
+vector<TaskInfo_t> fake_tasks;
+vector<VMInfo_t> fake_vms;
+Time_t fake_now = 0;
+
+MachineId_t Fake_AddMachine(CPUType_t cpu, unsigned cores, unsigned memory, bool gpus) {
+    MachineInfo_t info = {};
+    info.num_cpus = cores;
+    info.cpu = cpu;
+    info.memory_size = memory;
+    info.gpus = gpus;
+    info.performance = { 1000, 750, 500, 250 };
+    info.s_state = S0;
+    info.p_state = P0;
+    info.machine_id = MachineId_t(fake_machines.size());
+    fake_machines.push_back(info);
+    return info.machine_id;
+}
+
+TaskId_t Fake_AddTask(CPUType_t cpu, VMType_t vm_type, unsigned memory, uint64_t instructions,
+                      Time_t arrival, Time_t target, SLAType_t sla, bool gpu_capable) {
+    TaskInfo_t info = {};
+    info.total_instructions = info.remaining_instructions = instructions;
+    info.arrival = arrival;
+    info.target_completion = target;
+    info.gpu_capable = gpu_capable;
+    info.priority = MID_PRIORITY;
+    info.required_cpu = cpu;
+    info.required_memory = memory;
+    info.required_sla = sla;
+    info.required_vm = vm_type;
+    info.task_id = TaskId_t(fake_tasks.size());
+    fake_tasks.push_back(info);
+    return info.task_id;
+}
+
+void Fake_Reset() {
+    fake_machines.clear();
+    fake_tasks.clear();
+    fake_vms.clear();
+    fake_now = 0;
+}
+
+void SimOutput(string msg, unsigned verbose_level) {}
+
+void ThrowException(string err_msg) {
+    throw runtime_error(err_msg);
+}
+
+void ThrowException(string err_msg, string further_input) {
+    throw runtime_error(err_msg + further_input);
+}
+
+void ThrowException(string err_msg, unsigned further_input) {
+    throw runtime_error(err_msg + to_string(further_input));
+}
+
+CPUType_t Machine_GetCPUType(MachineId_t machine_id)            { return fake_machines.at(machine_id).cpu; }
+uint64_t Machine_GetEnergy(MachineId_t machine_id)              { return fake_machines.at(machine_id).energy_consumed; }
+MachineInfo_t Machine_GetInfo(MachineId_t machine_id)           { return fake_machines.at(machine_id); }
+unsigned Machine_GetTotal()                                     { return unsigned(fake_machines.size()); }
+
+double Machine_GetClusterEnergy() {
+    uint64_t energy = 0;
+    for(const MachineInfo_t & info : fake_machines)
+        energy += info.energy_consumed;
+    return double(energy);
+}
+
+void Machine_SetCorePerformance(MachineId_t machine_id, unsigned core_id, CPUPerformance_t p_state) {
+    fake_machines.at(machine_id).p_state = p_state;
+}
+
+void Machine_SetState(MachineId_t machine_id, MachineState_t s_state) {
+    fake_machines.at(machine_id).s_state = s_state;
+}
+
+double GetSLAReport(SLAType_t sla)                              { return 0.0; }
+Time_t Now()                                                    { return fake_now; }
+
+unsigned GetNumTasks()                                          { return unsigned(fake_tasks.size()); }
+TaskInfo_t GetTaskInfo(TaskId_t task_id)                        { return fake_tasks.at(task_id); }
+unsigned GetTaskMemory(TaskId_t task_id)                        { return fake_tasks.at(task_id).required_memory; }
+unsigned GetTaskPriority(TaskId_t task_id)                      { return fake_tasks.at(task_id).priority; }
+bool IsSLAViolated(TaskId_t task_id)                            { return fake_tasks.at(task_id).completion > fake_tasks.at(task_id).target_completion; }
+bool IsTaskCompleted(TaskId_t task_id)                          { return fake_tasks.at(task_id).completed; }
+bool IsTaskGPUCapable(TaskId_t task_id)                         { return fake_tasks.at(task_id).gpu_capable; }
+CPUType_t RequiredCPUType(TaskId_t task_id)                     { return fake_tasks.at(task_id).required_cpu; }
+SLAType_t RequiredSLA(TaskId_t task_id)                         { return fake_tasks.at(task_id).required_sla; }
+VMType_t RequiredVMType(TaskId_t task_id)                       { return fake_tasks.at(task_id).required_vm; }
+void SetTaskPriority(TaskId_t task_id, Priority_t priority)     { fake_tasks.at(task_id).priority = priority; }
+
+void VM_Attach(VMId_t vm_id, MachineId_t machine_id) {
+    fake_vms.at(vm_id).machine_id = machine_id;
+}
+
+void VM_AddTask(VMId_t vm_id, TaskId_t task_id, Priority_t priority) {
+    fake_vms.at(vm_id).active_tasks.push_back(task_id);
+}
+
+VMId_t VM_Create(VMType_t vm_type, CPUType_t cpu) {
+    VMId_t vm_id = VMId_t(fake_vms.size());
+    fake_vms.push_back(VMInfo_t{ {}, cpu, MachineId_t(-1), vm_id, vm_type });
+    return vm_id;
+}
+
+VMInfo_t VM_GetInfo(VMId_t vm_id)                               { return fake_vms.at(vm_id); }
+
+void VM_Migrate(VMId_t vm_id, MachineId_t machine_id) {
+    fake_vms.at(vm_id).machine_id = machine_id;
+}
+
+void VM_RemoveTask(VMId_t vm_id, TaskId_t task_id) {
+    vector<TaskId_t> & tasks = fake_vms.at(vm_id).active_tasks;
+    tasks.erase(remove(tasks.begin(), tasks.end(), task_id), tasks.end());
+}
+
+void VM_Shutdown(VMId_t vm_id) {
+    fake_vms.at(vm_id).machine_id = MachineId_t(-1);
+}
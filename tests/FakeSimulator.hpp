@@ -0,0 +1,27 @@
+//
+//  FakeSimulator.hpp
+//  CloudSim
+//
+//  In-memory stand-in for the simulator's side of Interfaces.h. A test describes its machines and
+//  tasks here before Cluster::Init(), moves the clock with fake_now, and reads back what the scheduler
+//  asked the simulator to do. Nothing runs on its own: state changes and migrations complete when the
+//  test calls the Cluster notifications.
+//
+
+#ifndef FakeSimulator_hpp
+#define FakeSimulator_hpp
+
+#include "Interfaces.h"
+
+extern vector<MachineInfo_t>    fake_machines;
+extern vector<TaskInfo_t>       fake_tasks;
+extern vector<VMInfo_t>         fake_vms;
+extern Time_t                   fake_now;
+
+// Machines get four P-states at 1000, 750, 500 and 250 MIPS and start in S0
+extern MachineId_t      Fake_AddMachine(CPUType_t cpu, unsigned cores, unsigned memory, bool gpus);
+extern TaskId_t         Fake_AddTask(CPUType_t cpu, VMType_t vm_type, unsigned memory, uint64_t instructions,
+                                     Time_t arrival, Time_t target, SLAType_t sla = SLA0, bool gpu_capable = false);
+extern void             Fake_Reset();
+
+#endif /* FakeSimulator_hpp */
@@ -0,0 +1,59 @@
+//
+//  MetricsTest.cpp
+//  CloudSim
+//
+//  Checks that SampleRing keeps its order and bound across many wrap-arounds, first on one thread
+//  and then between a producer and a consumer thread as Metrics uses it.
+//
+
+#include "Metrics.hpp"
+#include "Test.hpp"
+
+#define ITEMS 100000
+
+int main() {
+    SampleRing<unsigned> ring;
+    ring.Reserve(3);
+    unsigned item = 0;
+    CHECK(ring.Capacity() == 3);
+    CHECK(ring.Size() == 0);
+    CHECK(!ring.Pop(item));
+
+    // Full at the capacity, whichever slot the ring starts from
+    unsigned next = 0, expected = 0;
+    for(unsigned round = 0; round < 10; round++) {
+        for(unsigned i = 0; i < 3; i++)
+            CHECK(ring.Push(next++));
+        CHECK(ring.Size() == 3);
+        CHECK(!ring.Push(next));
+        CHECK(ring.Pop(item) && item == expected++);
+        CHECK(ring.Push(next++));
+        CHECK(!ring.Push(next));
+        while(ring.Pop(item))
+            CHECK(item == expected++);
+        CHECK(ring.Size() == 0);
+    }
+    CHECK(expected == next);
+
+    // Every item arrives once and in order, none is lost when Push() succeeds
+    SampleRing<unsigned> shared;
+    shared.Reserve(64);
+    unsigned pushed = 0;
+    thread producer([&]() {
+        for(unsigned i = 0; i < ITEMS; i++) {
+            while(!shared.Push(i))
+                this_thread::yield();
+            pushed++;
+        }
+    });
+    unsigned received = 0;
+    bool ordered = true;
+    while(received < ITEMS)
+        if(shared.Pop(item))
+            ordered = ordered && item == received++;
+    producer.join();
+    CHECK(ordered);
+    CHECK(pushed == ITEMS);
+    CHECK(shared.Size() == 0);
+    return Test_Result("MetricsTest");
+}
@@ -0,0 +1,59 @@
+//
+//  ParamsTest.cpp
+//  CloudSim
+//
+//  Checks the parsing of the CLOUDSIM_ parameters and the defaults behind them.
+//
+
+#include <cstdlib>
+
+#include "Params.hpp"
+#include "Test.hpp"
+
+// True if reading the unsigned parameter TEST with the given value is refused
+static bool Refused(const char * value) {
+    setenv("CLOUDSIM_TEST", value, 1);
+    try {
+        Param_Get("TEST", 7u);
+    }
+    catch(const runtime_error &) {
+        return true;
+    }
+    return false;
+}
+
+int main() {
+    unsetenv("CLOUDSIM_TEST");
+    CHECK(Param_Get("TEST", 7u) == 7);
+    CHECK(Param_Get("TEST", 0.5) == 0.5);
+    CHECK(Param_Get("TEST", "fallback") == "fallback");
+
+    setenv("CLOUDSIM_TEST", "42", 1);
+    CHECK(Param_Get("TEST", 7u) == 42);
+    CHECK(Param_Get("TEST", 0.5) == 42.0);
+    CHECK(Param_Get("TEST", "fallback") == "42");
+    setenv("CLOUDSIM_TEST", "4294967295", 1);
+    CHECK(Param_Get("TEST", 7u) == 4294967295u);
+    setenv("CLOUDSIM_TEST", "0.25", 1);
+    CHECK(Param_Get("TEST", 1.0) == 0.25);
+    setenv("CLOUDSIM_TEST", "", 1);
+    CHECK(Param_Get("TEST", "fallback") == "");
+
+    CHECK(Refused(""));
+    CHECK(Refused("12abc"));
+    CHECK(Refused("0.5"));
+    CHECK(Refused("-1"));
+    CHECK(Refused("4294967296"));
+    CHECK(Refused("99999999999999999999999"));
+    setenv("CLOUDSIM_TEST", "fast", 1);
+    bool refused = false;
+    try {
+        Param_Get("TEST", 1.0);
+    }
+    catch(const runtime_error &) {
+        refused = true;
+    }
+    CHECK(refused);
+    unsetenv("CLOUDSIM_TEST");
+    return Test_Result("ParamsTest");
+}
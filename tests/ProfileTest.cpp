@@ -0,0 +1,103 @@
+//
+//  ProfileTest.cpp
+//  CloudSim
+//
+//  Times a callback that makes a simulator call, inside which the simulator calls back into the scheduler,
+//  as VM_AddTask() does with MemoryWarning(). Each level sleeps for a known time, so every own time can be
+//  checked against its sleeps.
+//
+
+#include <chrono>
+#include <cstdlib>
+#include <map>
+#include <thread>
+
+#include <unistd.h>
+
+#include "Profile.hpp"
+#include "Runner.hpp"
+#include "Test.hpp"
+
+#define SLACK_NS 20000000           // Scheduling noise allowed on top of each sleep
+
+static void Sleep(unsigned milliseconds) {
+    this_thread::sleep_for(chrono::milliseconds(milliseconds));
+}
+
+// Makes the given number of 8 byte allocations, through operator new itself so none can be elided
+static void Allocate(unsigned allocations) {
+    static void * volatile sink;
+    for(unsigned i = 0; i < allocations; i++) {
+        sink = operator new(8);
+        operator delete(sink);
+    }
+}
+
+static uint64_t Value(map<string, string> & values, const string & name) {
+    CHECK(values.count(name) == 1);
+    return values.count(name) ? stoull(values[name]) : 0;
+}
+
+static void CheckAbout(uint64_t ns, unsigned milliseconds) {
+    CHECK(ns >= uint64_t(milliseconds) * 1000000);
+    CHECK(ns < uint64_t(milliseconds) * 1000000 + SLACK_NS);
+}
+
+int main() {
+    string report = "/tmp/cloudsim_profile_test_" + to_string(getpid());
+    setenv("CLOUDSIM_PROFILE", report.c_str(), 1);
+    Profile_Start();
+    Sleep(5);                                   // In the simulator before the callback
+    Allocate(1);
+    {
+        ProfileScope callback(PROFILE_NEW_TASK);
+        Sleep(10);
+        {
+            ProfileScope call(PROFILE_VM_ADD_TASK);
+            Sleep(20);
+            Allocate(2);
+            {
+                ProfileScope warning(PROFILE_MEMORY_WARNING);
+                Sleep(40);
+                Allocate(4);
+            }
+            Sleep(20);
+            Allocate(2);
+        }
+        Sleep(10);
+        Allocate(8);
+    }
+    Sleep(5);
+    {
+        ProfileScope callback(PROFILE_TASK_COMPLETION);
+        Sleep(10);
+    }
+    Profile_Report(0);
+
+    map<string, string> values;
+    CHECK(Runner_ReadValues(report, values));
+    unlink(report.c_str());
+    CHECK(Value(values, "new_task.calls") == 1);
+    CHECK(Value(values, "vm_add_task.calls") == 1);
+    CHECK(Value(values, "memory_warning.calls") == 1);
+    CHECK(Value(values, "task_completion.calls") == 1);
+    CheckAbout(Value(values, "new_task.scheduler_ns"), 20);
+    CheckAbout(Value(values, "vm_add_task.simulator_ns"), 40);
+    CheckAbout(Value(values, "memory_warning.scheduler_ns"), 40);
+    CheckAbout(Value(values, "task_completion.scheduler_ns"), 10);
+    // The nested callback is not preceded by time in the event loop, the outer ones are
+    CheckAbout(Value(values, "new_task.simulator_ns"), 5);
+    CheckAbout(Value(values, "task_completion.simulator_ns"), 5);
+    CHECK(Value(values, "memory_warning.simulator_ns") < SLACK_NS);
+    CHECK(Value(values, "callbacks") == 3);
+    CheckAbout(Value(values, "scheduler_ns"), 70);
+#ifdef SIM_PROFILE_ALLOC
+    CHECK(Value(values, "new_task.simulator_allocations") == 1);
+    CHECK(Value(values, "new_task.scheduler_allocations") == 8);
+    CHECK(Value(values, "vm_add_task.simulator_allocations") == 4);
+    CHECK(Value(values, "memory_warning.scheduler_allocations") == 4);
+    CHECK(Value(values, "memory_warning.simulator_allocations") == 0);
+    CHECK(Value(values, "new_task.scheduler_allocated_bytes") == 64);
+#endif
+    return Test_Result("ProfileTest");
+}
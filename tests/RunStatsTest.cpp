@@ -0,0 +1,53 @@
+//
+//  RunStatsTest.cpp
+//  CloudSim
+//
+//  Checks the running SLA aggregate against tasks with known lateness.
+//
+
+#include "FakeSimulator.hpp"
+#include "RunStats.hpp"
+#include "Test.hpp"
+
+int main() {
+    RunStats stats;
+    CHECK(stats.ViolationRate(SLA0) == 0.0);
+    CHECK(stats.LatenessPercentile(SLA0, 0.99) == 0);
+
+    // Four SLA0 tasks, two on time and two late by 100 and 5000 us
+    Time_t finished[4] = { 900, 1000, 1100, 6000 };
+    for(Time_t now : finished)
+        stats.TaskCompleted(now, Fake_AddTask(X86, LINUX, 10, 1000, 0, 1000, SLA0), false);
+    CHECK(stats.Completed(SLA0) == 4);
+    CHECK(stats.Violated(SLA0) == 2);
+    CHECK(stats.ViolationRate(SLA0) == 50.0);
+    CHECK(stats.MaxLateness(SLA0) == 5000);
+    CHECK(stats.LatenessPercentile(SLA0, 0.25) == 0);
+    CHECK(stats.LatenessPercentile(SLA0, 0.50) == 128);            // The bucket of 100 us ends at 2^7
+    CHECK(stats.LatenessPercentile(SLA0, 0.99) == 5000);           // Capped at the maximum
+    CHECK(stats.Completed(SLA1) == 0 && stats.ViolationRate(SLA1) == 0.0);
+
+    // GPU-capable tasks are split by where they ran
+    stats.TaskCompleted(2000, Fake_AddTask(X86, LINUX, 10, 40000, 1000, 5000, SLA2, true), true);
+    stats.TaskCompleted(5000, Fake_AddTask(X86, LINUX, 10, 40000, 1000, 5000, SLA2, true), false);
+    CHECK(stats.GPUCapable(true) == 1 && stats.GPUCapable(false) == 1);
+    CHECK(stats.GPUThroughput(true) == 40.0);
+    CHECK(stats.GPUThroughput(false) == 10.0);
+    CHECK(stats.Completed(SLA2) == 2 && stats.Violated(SLA2) == 0);
+
+    // Estimates are scored against the time they looked ahead
+    stats.EstimateChecked(ESTIMATE_FREE_CORE, 0, 1000, 1050);
+    stats.EstimateChecked(ESTIMATE_FREE_CORE, 0, 1000, 2000);
+    CHECK(stats.Estimates(ESTIMATE_FREE_CORE) == 2);
+    CHECK(stats.EstimatesAccurate(ESTIMATE_FREE_CORE) == 50.0);
+    CHECK(stats.EstimateError(ESTIMATE_FREE_CORE) > 0.273 && stats.EstimateError(ESTIMATE_FREE_CORE) < 0.274);
+    CHECK(stats.Estimates(ESTIMATE_DRAIN) == 0 && stats.EstimateError(ESTIMATE_DRAIN) == 0.0);
+
+    Fake_AddMachine(X86, 4, 1000, false);
+    Fake_AddMachine(ARM, 4, 1000, false);
+    fake_machines[0].energy_consumed = 300;
+    fake_machines[1].energy_consumed = 200;
+    CHECK(stats.Energy() == 500);
+    CHECK(stats.MachineEnergy().size() == 2 && stats.MachineEnergy()[1] == 200);
+    return Test_Result("RunStatsTest");
+}
@@ -0,0 +1,26 @@
+//
+//  Test.hpp
+//  CloudSim
+//
+//  Minimal checks for the unit tests: each failed CHECK() prints where it failed, and Test_Result()
+//  turns the count into the exit status.
+//
+
+#ifndef Test_hpp
+#define Test_hpp
+
+#include <iostream>
+
+#include "SimTypes.h"
+
+extern unsigned         test_failures;
+
+#define CHECK(condition) \
+    do { if(!(condition)) { test_failures++; cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed" << endl; } } while(0)
+
+inline int Test_Result(const char * name) {
+    cout << name << ": " << (test_failures ? "FAILED" : "passed") << endl;
+    return test_failures ? 1 : 0;
+}
+
+#endif /* Test_hpp */